@@ -0,0 +1,250 @@
+#include "ClaimsBuilder.h"
+#include "P256.h"
+#include "Ed25519.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const size_t TO_END = (size_t)-1;
+
+ClaimsBuilder::ClaimsBuilder() {
+    this->clear();
+}
+
+void ClaimsBuilder::clear() {
+    this->text.assign("{}");
+    this->slots.clear();
+    this->_dirty(0, TO_END);
+    this->midstateValid = false;
+}
+
+ClaimsBuilder& ClaimsBuilder::add(const std::string& name, const std::string& value) {
+    this->_name(name);
+    this->text.push_back('"');
+    this->_escape(value);
+    this->text.push_back('"');
+    this->_close();
+    return *this;
+}
+
+ClaimsBuilder& ClaimsBuilder::add(const std::string& name, const char* value) {
+    return this->add(name, std::string(value));
+}
+
+ClaimsBuilder& ClaimsBuilder::add(const std::string& name, long long value) {
+    char digits[24];
+    int len = std::snprintf(digits, sizeof(digits), "%lld", value);
+
+    this->_name(name);
+    this->text.append(digits, len);
+    this->_close();
+    return *this;
+}
+
+ClaimsBuilder& ClaimsBuilder::add(const std::string& name, bool value) {
+    this->_name(name);
+    this->text.append(value ? "true" : "false");
+    this->_close();
+    return *this;
+}
+
+ClaimsBuilder& ClaimsBuilder::addJSON(const std::string& name, const std::string& json) {
+    this->_name(name);
+    this->text.append(json);
+    this->_close();
+    return *this;
+}
+
+ClaimsBuilder::Slot ClaimsBuilder::addSlot(const std::string& name, int width) {
+    if (width < 1 || width > 20) throw std::invalid_argument("claim slot width must be 1 to 20");
+
+    this->_name(name);
+
+    Slot slot;
+    slot.offset = this->text.size();
+    slot.width = width;
+    this->text.append(width - 1, ' ');
+    this->text.push_back('0');
+    this->_close();
+
+    this->slots.push_back(slot);
+    this->midstateValid = false;
+    return slot;
+}
+
+void ClaimsBuilder::set(const Slot& slot, unsigned long long value) {
+    char* field = &this->text[slot.offset];
+    int i = slot.width;
+
+    do {
+        if (i == 0) throw std::invalid_argument("value does not fit the claim slot");
+        field[--i] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (i > 0) field[--i] = ' ';
+
+    this->_dirty(slot.offset, slot.offset + slot.width);
+}
+
+const std::string& ClaimsBuilder::json() const {
+    return this->text;
+}
+
+const std::string& ClaimsBuilder::signingInput(const std::string& header, unsigned char* hash) {
+    if (this->input.empty() || header != this->header) {
+        this->header = header;
+        this->input = Digest::urlsafeB64Encode(header);
+        this->input.push_back('.');
+        this->payloadAt = this->input.size();
+        this->_dirty(0, TO_END);
+        this->midstateValid = false;
+    }
+
+    if (this->dirtyBegin < this->dirtyEnd) {
+        const unsigned char* bytes = (const unsigned char*)this->text.data();
+        size_t n = this->text.size();
+        size_t first = this->dirtyBegin / 3;
+        size_t last = (std::min(this->dirtyEnd, n) + 2) / 3;
+
+        this->input.resize(this->payloadAt + Digest::urlsafeB64Length(n));
+        Digest::urlsafeB64Encode(bytes + 3 * first, std::min(n, 3 * last) - 3 * first, &this->input[this->payloadAt + 4 * first]);
+
+        if (this->payloadAt + 4 * first < this->midstateBytes) this->midstateValid = false;
+        this->dirtyBegin = this->dirtyEnd = 0;
+    }
+
+    if (hash == NULL) return this->input;
+
+    // the blocks in front of the first slot only change with the header or the claim set
+    if (!this->midstateValid) {
+        size_t stable = this->input.size();
+        for (size_t i = 0; i < this->slots.size(); i++) {
+            stable = std::min(stable, this->payloadAt + 4 * (this->slots[i].offset / 3));
+        }
+
+        SHA256 sha;
+        this->midstateBytes = stable / 64 * 64;
+        sha.update(this->input.data(), this->midstateBytes);
+        std::memcpy(this->midstate, sha.H, sizeof(this->midstate));
+        this->midstateValid = true;
+    }
+
+    SHA256 sha;
+    sha.resume(this->midstate, this->midstateBytes);
+    sha.update(this->input.data() + this->midstateBytes, this->input.size() - this->midstateBytes);
+    sha.final(hash);
+
+    return this->input;
+}
+
+// The claims variants sign builder.signingInput() and append the signature to a
+// copy of it; the builder keeps its encoding for the next patch
+std::string RSALite::createJWT(const std::string& header, ClaimsBuilder& claims, RSAKey& rsaKey) {
+    RSALiteStageClock clock;
+    unsigned char hash[32];
+    const std::string& signingInput = claims.signingInput(header, hash);
+    clock.lap(STAGE_HASH);
+
+    std::string signature(rsaKey.signatureLength(), '\0');
+    rsaKey._sign(hash, (unsigned char*)&signature[0], clock);
+
+    std::string jwt = signingInput + "." + Digest::urlsafeB64Encode(signature);
+    clock.lap(STAGE_ENCODE);
+    clock.finish();
+
+    return jwt;
+}
+
+std::string RSALite::createJWT(const std::string& header, ClaimsBuilder& claims, ECKey& ecKey) {
+    RSALiteStageClock clock;
+    unsigned char hash[32], signature[64];
+    const std::string& signingInput = claims.signingInput(header, hash);
+    clock.lap(STAGE_HASH);
+
+    ecKey.sign(hash, signature);
+    clock.lap(STAGE_SIGN);
+
+    std::string jwt = signingInput + "." + Digest::urlsafeB64Encode(std::string((const char*)signature, 64));
+    clock.lap(STAGE_ENCODE);
+    clock.finish();
+
+    return jwt;
+}
+
+std::string RSALite::createJWT(const std::string& header, ClaimsBuilder& claims, const HMACSHA256& hmacKey) {
+    RSALiteStageClock clock;
+    const std::string& signingInput = claims.signingInput(header);
+    clock.lap(STAGE_ENCODE);
+
+    unsigned char mac[32];
+    hmacKey.sign(signingInput.data(), signingInput.size(), mac);
+    clock.lap(STAGE_SIGN);
+
+    std::string jwt = signingInput + "." + Digest::urlsafeB64Encode(std::string((const char*)mac, 32));
+    clock.lap(STAGE_ENCODE);
+    clock.finish();
+
+    return jwt;
+}
+
+std::string RSALite::createJWT(const std::string& header, ClaimsBuilder& claims, Ed25519Key& edKey) {
+    RSALiteStageClock clock;
+    const std::string& signingInput = claims.signingInput(header);
+    clock.lap(STAGE_ENCODE);
+
+    unsigned char signature[64];
+    edKey.sign(signingInput.data(), signingInput.size(), signature);
+    clock.lap(STAGE_SIGN);
+
+    std::string jwt = signingInput + "." + Digest::urlsafeB64Encode(std::string((const char*)signature, 64));
+    clock.lap(STAGE_ENCODE);
+    clock.finish();
+
+    return jwt;
+}
+
+// Reopens the object for one more member; the old closing brace is the first changed byte
+void ClaimsBuilder::_name(const std::string& name) {
+    this->_dirty(this->text.size() - 1, TO_END);
+    this->text.pop_back();
+
+    if (this->text.size() > 1) this->text.push_back(',');
+    this->text.push_back('"');
+    this->_escape(name);
+    this->text.append("\":");
+}
+
+void ClaimsBuilder::_close() {
+    this->text.push_back('}');
+}
+
+void ClaimsBuilder::_dirty(size_t begin, size_t end) {
+    if (this->dirtyBegin >= this->dirtyEnd) {
+        this->dirtyBegin = begin;
+        this->dirtyEnd = end;
+        return;
+    }
+    this->dirtyBegin = std::min(this->dirtyBegin, begin);
+    this->dirtyEnd = std::max(this->dirtyEnd, end);
+}
+
+void ClaimsBuilder::_escape(const std::string& s) {
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = (unsigned char)s[i];
+
+        if (c == '"' || c == '\\') {
+            this->text.push_back('\\');
+            this->text.push_back((char)c);
+        }
+        else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            this->text.append(escaped);
+        }
+        else {
+            this->text.push_back((char)c);
+        }
+    }
+}
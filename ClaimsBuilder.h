@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "RSALite.h"
+
+#ifndef CLAIMSBUILDER_H
+#define CLAIMSBUILDER_H
+
+// Serializes a JWT claims object into a buffer that is kept between tokens.
+// Numeric slots are written at a fixed width (right-aligned, space-padded,
+// still valid JSON), so iat / exp / jti can be patched in place with set()
+// for the next token. signingInput() re-encodes only the base64url groups
+// that changed since the last call and resumes SHA-256 from the state saved
+// before the first slot, so a patched token hashes just the blocks from
+// there on. Once the buffers have grown to size nothing allocates.
+class ClaimsBuilder
+{
+public:
+    struct Slot
+    {
+        size_t offset = 0;      // first character of the field in json()
+        int width = 0;
+    };
+
+    ClaimsBuilder();
+
+    void clear();
+
+    ClaimsBuilder& add(const std::string& name, const std::string& value);
+    ClaimsBuilder& add(const std::string& name, const char* value);
+    ClaimsBuilder& add(const std::string& name, long long value);
+    ClaimsBuilder& add(const std::string& name, bool value);
+    ClaimsBuilder& addJSON(const std::string& name, const std::string& json);     // value inserted verbatim
+
+    // up to 20 digits; 10 covers Unix seconds until 2286
+    Slot addSlot(const std::string& name, int width = 10);
+    void set(const Slot& slot, unsigned long long value);
+
+    const std::string& json() const;
+
+    // base64url(header) "." base64url(json()), and its SHA-256 unless hash is NULL
+    const std::string& signingInput(const std::string& header, unsigned char* hash = NULL);
+
+private:
+    std::string text;           // always a complete object
+    std::vector<Slot> slots;
+
+    std::string header;         // the header the encoding below belongs to
+    std::string input;
+    size_t payloadAt = 0;       // where base64url(json) starts in input
+    size_t dirtyBegin = 0;      // json bytes changed since the last encoding
+    size_t dirtyEnd = 0;
+
+    unsigned int midstate[8];
+    size_t midstateBytes = 0;   // input bytes absorbed into midstate, a multiple of 64
+    bool midstateValid = false;
+
+    void _name(const std::string& name);
+    void _close();
+    void _dirty(size_t begin, size_t end);
+    void _escape(const std::string& s);
+};
+
+#endif
@@ -0,0 +1,473 @@
+#include "Ed25519.h"
+#include "P256.h"
+#include "RSALite.h"
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+static const uint64_t MASK51 = (1ULL << 51) - 1;
+
+// d, 2d and the base point, radix 2^51 limbs
+static const Ed25519::Fe ED_D = { 0x34dca135978a3ULL, 0x1a8283b156ebdULL, 0x5e7a26001c029ULL, 0x739c663a03cbbULL, 0x52036cee2b6ffULL };
+static const Ed25519::Fe ED_D2 = { 0x69b9426b2f159ULL, 0x35050762add7aULL, 0x3cf44c0038052ULL, 0x6738cc7407977ULL, 0x2406d9dc56dffULL };
+static const Ed25519::Fe ED_BX = { 0x62d608f25d51aULL, 0x412a4b4f6592aULL, 0x75b7171a4b31dULL, 0x1ff60527118feULL, 0x216936d3cd6e5ULL };
+static const Ed25519::Fe ED_BY = { 0x6666666666658ULL, 0x4ccccccccccccULL, 0x1999999999999ULL, 0x3333333333333ULL, 0x6666666666666ULL };
+
+// group order L = 2^252 + 27742317777372353535851937790883648493, 32-bit limbs
+static const P256::Int ED_L = { 0x5cf5d3ed, 0x5812631a, 0xa2f79cd6, 0x14def9de, 0, 0, 0, 0x10000000 };
+
+// id-Ed25519, DER value
+static const unsigned char OID_ED25519[] = { 0x2b, 0x65, 0x70 };
+
+static Ed25519::NielsPoint COMB[1 << Ed25519::COMB_TEETH];
+static P256::Modulus ORDER;
+static P256::Int ORDER_R3;      // R^3 mod L, folds the high half of a 512-bit hash
+static std::once_flag ED25519_READY;
+
+// 64x64 -> 128-bit products for the field multiply
+#if defined(__SIZEOF_INT128__)
+typedef unsigned __int128 _u128;
+
+static inline _u128 _mul64(uint64_t a, uint64_t b) { return (_u128)a * b; }
+static inline void _acc(_u128& r, _u128 x) { r += x; }
+static inline void _acc(_u128& r, uint64_t x) { r += x; }
+static inline uint64_t _lo(_u128 x) { return (uint64_t)x; }
+static inline uint64_t _shr51(_u128 x) { return (uint64_t)(x >> 51); }
+#else
+// 32-bit targets (ESP32) and MSVC: built from four 32x32 products
+struct _u128 { uint64_t lo; uint64_t hi; };
+
+static inline _u128 _mul64(uint64_t a, uint64_t b) {
+    uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    _u128 r;
+    r.lo = (mid << 32) | (uint32_t)p00;
+    r.hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return r;
+}
+static inline void _acc(_u128& r, _u128 x) { r.lo += x.lo; r.hi += x.hi + (r.lo < x.lo); }
+static inline void _acc(_u128& r, uint64_t x) { r.lo += x; r.hi += (r.lo < x); }
+static inline uint64_t _lo(_u128 x) { return x.lo; }
+static inline uint64_t _shr51(_u128 x) { return (x.lo >> 51) | (x.hi << 13); }
+#endif
+
+static void _feCopy(Ed25519::Fe r, const Ed25519::Fe a) {
+    std::memcpy(r, a, sizeof(Ed25519::Fe));
+}
+
+static void _feSet(Ed25519::Fe r, uint64_t v) {
+    r[0] = v;
+    r[1] = r[2] = r[3] = r[4] = 0;
+}
+
+// r = mask ? a : r, mask all ones or zero
+static void _feCmov(Ed25519::Fe r, const Ed25519::Fe a, uint64_t mask) {
+    for (int i = 0; i < 5; i++) r[i] = (r[i] & ~mask) | (a[i] & mask);
+}
+
+// brings every limb back to 51 bits (limb 1 may keep a few extra)
+static void _feCarry(Ed25519::Fe r) {
+    uint64_t c;
+    c = r[0] >> 51; r[0] &= MASK51; r[1] += c;
+    c = r[1] >> 51; r[1] &= MASK51; r[2] += c;
+    c = r[2] >> 51; r[2] &= MASK51; r[3] += c;
+    c = r[3] >> 51; r[3] &= MASK51; r[4] += c;
+    c = r[4] >> 51; r[4] &= MASK51; r[0] += c * 19;
+    c = r[0] >> 51; r[0] &= MASK51; r[1] += c;
+}
+
+static void _feReduce(Ed25519::Fe r, _u128 t0, _u128 t1, _u128 t2, _u128 t3, _u128 t4) {
+    uint64_t c;
+    c = _shr51(t0); r[0] = _lo(t0) & MASK51; _acc(t1, c);
+    c = _shr51(t1); r[1] = _lo(t1) & MASK51; _acc(t2, c);
+    c = _shr51(t2); r[2] = _lo(t2) & MASK51; _acc(t3, c);
+    c = _shr51(t3); r[3] = _lo(t3) & MASK51; _acc(t4, c);
+    c = _shr51(t4); r[4] = _lo(t4) & MASK51;
+    r[0] += c * 19;
+    r[1] += r[0] >> 51;
+    r[0] &= MASK51;
+}
+
+void Ed25519::feAdd(Fe r, const Fe a, const Fe b) {
+    for (int i = 0; i < 5; i++) r[i] = a[i] + b[i];
+    _feCarry(r);
+}
+
+// a + 4p - b keeps every limb positive for inputs below 2^53
+void Ed25519::feSub(Fe r, const Fe a, const Fe b) {
+    r[0] = a[0] + 0x1fffffffffffb4ULL - b[0];
+    for (int i = 1; i < 5; i++) r[i] = a[i] + 0x1ffffffffffffcULL - b[i];
+    _feCarry(r);
+}
+
+void Ed25519::feMul(Fe r, const Fe a, const Fe b) {
+    uint64_t b1 = b[1] * 19, b2 = b[2] * 19, b3 = b[3] * 19, b4 = b[4] * 19;
+    _u128 t0, t1, t2, t3, t4;
+
+    t0 = _mul64(a[0], b[0]); _acc(t0, _mul64(a[1], b4)); _acc(t0, _mul64(a[2], b3)); _acc(t0, _mul64(a[3], b2)); _acc(t0, _mul64(a[4], b1));
+    t1 = _mul64(a[0], b[1]); _acc(t1, _mul64(a[1], b[0])); _acc(t1, _mul64(a[2], b4)); _acc(t1, _mul64(a[3], b3)); _acc(t1, _mul64(a[4], b2));
+    t2 = _mul64(a[0], b[2]); _acc(t2, _mul64(a[1], b[1])); _acc(t2, _mul64(a[2], b[0])); _acc(t2, _mul64(a[3], b4)); _acc(t2, _mul64(a[4], b3));
+    t3 = _mul64(a[0], b[3]); _acc(t3, _mul64(a[1], b[2])); _acc(t3, _mul64(a[2], b[1])); _acc(t3, _mul64(a[3], b[0])); _acc(t3, _mul64(a[4], b4));
+    t4 = _mul64(a[0], b[4]); _acc(t4, _mul64(a[1], b[3])); _acc(t4, _mul64(a[2], b[2])); _acc(t4, _mul64(a[3], b[1])); _acc(t4, _mul64(a[4], b[0]));
+
+    _feReduce(r, t0, t1, t2, t3, t4);
+}
+
+void Ed25519::feSquare(Fe r, const Fe a) {
+    uint64_t a0x2 = a[0] * 2, a1x2 = a[1] * 2, a2x2 = a[2] * 2, a3x2 = a[3] * 2;
+    uint64_t a3x19 = a[3] * 19, a4x19 = a[4] * 19;
+    _u128 t0, t1, t2, t3, t4;
+
+    t0 = _mul64(a[0], a[0]); _acc(t0, _mul64(a1x2, a4x19)); _acc(t0, _mul64(a2x2, a3x19));
+    t1 = _mul64(a0x2, a[1]); _acc(t1, _mul64(a[3], a3x19)); _acc(t1, _mul64(a2x2, a4x19));
+    t2 = _mul64(a0x2, a[2]); _acc(t2, _mul64(a[1], a[1])); _acc(t2, _mul64(a3x2, a4x19));
+    t3 = _mul64(a0x2, a[3]); _acc(t3, _mul64(a1x2, a[2])); _acc(t3, _mul64(a[4], a4x19));
+    t4 = _mul64(a0x2, a[4]); _acc(t4, _mul64(a1x2, a[3])); _acc(t4, _mul64(a[2], a[2]));
+
+    _feReduce(r, t0, t1, t2, t3, t4);
+}
+
+static void _feSquareTimes(Ed25519::Fe r, const Ed25519::Fe a, int n) {
+    Ed25519::feSquare(r, a);
+    for (int i = 1; i < n; i++) Ed25519::feSquare(r, r);
+}
+
+// a^(p-2) with the usual 254 squarings / 11 multiplications chain
+void Ed25519::feInvert(Fe r, const Fe a) {
+    Fe z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    feSquare(z2, a);
+    _feSquareTimes(t, z2, 2);
+    feMul(z9, t, a);
+    feMul(z11, z9, z2);
+    feSquare(t, z11);
+    feMul(z2_5_0, t, z9);
+    _feSquareTimes(t, z2_5_0, 5);
+    feMul(z2_10_0, t, z2_5_0);
+    _feSquareTimes(t, z2_10_0, 10);
+    feMul(z2_20_0, t, z2_10_0);
+    _feSquareTimes(t, z2_20_0, 20);
+    feMul(t, t, z2_20_0);
+    _feSquareTimes(t, t, 10);
+    feMul(z2_50_0, t, z2_10_0);
+    _feSquareTimes(t, z2_50_0, 50);
+    feMul(z2_100_0, t, z2_50_0);
+    _feSquareTimes(t, z2_100_0, 100);
+    feMul(t, t, z2_100_0);
+    _feSquareTimes(t, t, 50);
+    feMul(t, t, z2_50_0);
+    _feSquareTimes(t, t, 5);
+    feMul(r, t, z11);
+}
+
+// canonical little-endian encoding, fully reduced mod p
+void Ed25519::feToBytes(unsigned char out[32], const Fe a) {
+    Fe t;
+    _feCopy(t, a);
+    _feCarry(t);
+    _feCarry(t);
+
+    // q = 1 iff t >= p
+    uint64_t q = (t[0] + 19) >> 51;
+    for (int i = 1; i < 5; i++) q = (t[i] + q) >> 51;
+
+    t[0] += 19 * q;
+    for (int i = 0; i < 4; i++) {
+        t[i + 1] += t[i] >> 51;
+        t[i] &= MASK51;
+    }
+    t[4] &= MASK51;
+
+    uint64_t w[4] = {
+        t[0] | (t[1] << 51),
+        (t[1] >> 13) | (t[2] << 38),
+        (t[2] >> 26) | (t[3] << 25),
+        (t[3] >> 39) | (t[4] << 12)
+    };
+    for (int i = 0; i < 32; i++) out[i] = (unsigned char)(w[i / 8] >> (8 * (i % 8)));
+}
+
+// dbl-2008-hwcd, a = -1
+void Ed25519::_double(ExtendedPoint& r, const ExtendedPoint& p) {
+    Fe a, b, c, e, f, g, h;
+
+    feSquare(a, p.X);
+    feSquare(b, p.Y);
+    feSquare(c, p.Z);
+    feAdd(c, c, c);
+    feAdd(e, p.X, p.Y);
+    feSquare(e, e);
+    feAdd(h, a, b);
+    feSub(e, h, e);         // -(2XY)
+    feSub(g, a, b);         // -(Y^2 - X^2)
+    feAdd(f, c, g);         // -(G - C)
+
+    feMul(r.X, e, f);
+    feMul(r.Y, g, h);
+    feMul(r.T, e, h);
+    feMul(r.Z, f, g);
+}
+
+// add-2008-hwcd-3, complete for a = -1
+void Ed25519::_add(ExtendedPoint& r, const ExtendedPoint& p, const ExtendedPoint& q) {
+    Fe a, b, c, d, e, f, g, h, t;
+
+    feSub(a, p.Y, p.X);
+    feSub(t, q.Y, q.X);
+    feMul(a, a, t);
+    feAdd(b, p.Y, p.X);
+    feAdd(t, q.Y, q.X);
+    feMul(b, b, t);
+    feMul(c, p.T, q.T);
+    feMul(c, c, ED_D2);
+    feMul(d, p.Z, q.Z);
+    feAdd(d, d, d);
+
+    feSub(e, b, a);
+    feSub(f, d, c);
+    feAdd(g, d, c);
+    feAdd(h, b, a);
+
+    feMul(r.X, e, f);
+    feMul(r.Y, g, h);
+    feMul(r.T, e, h);
+    feMul(r.Z, f, g);
+}
+
+// madd-2008-hwcd-3 against a precomputed affine point
+void Ed25519::_addNiels(ExtendedPoint& r, const ExtendedPoint& p, const NielsPoint& q) {
+    Fe a, b, c, d, e, f, g, h;
+
+    feSub(a, p.Y, p.X);
+    feMul(a, a, q.yMinusX);
+    feAdd(b, p.Y, p.X);
+    feMul(b, b, q.yPlusX);
+    feMul(c, p.T, q.xy2d);
+    feAdd(d, p.Z, p.Z);
+
+    feSub(e, b, a);
+    feSub(f, d, c);
+    feAdd(g, d, c);
+    feAdd(h, b, a);
+
+    feMul(r.X, e, f);
+    feMul(r.Y, g, h);
+    feMul(r.T, e, h);
+    feMul(r.Z, f, g);
+}
+
+static void _toNiels(Ed25519::NielsPoint& r, const Ed25519::ExtendedPoint& p) {
+    Ed25519::Fe zinv, x, y;
+
+    Ed25519::feInvert(zinv, p.Z);
+    Ed25519::feMul(x, p.X, zinv);
+    Ed25519::feMul(y, p.Y, zinv);
+    Ed25519::feAdd(r.yPlusX, y, x);
+    Ed25519::feSub(r.yMinusX, y, x);
+    Ed25519::feMul(r.xy2d, x, y);
+    Ed25519::feMul(r.xy2d, r.xy2d, ED_D2);
+}
+
+static void _identity(Ed25519::ExtendedPoint& r) {
+    _feSet(r.X, 0);
+    _feSet(r.Y, 1);
+    _feSet(r.Z, 1);
+    _feSet(r.T, 0);
+}
+
+void Ed25519::_init() {
+    // COMB[idx] = sum of 2^(SPACING * t) * B over the set bits t of idx; COMB[0] is the identity
+    ExtendedPoint base[COMB_TEETH];
+    _feCopy(base[0].X, ED_BX);
+    _feCopy(base[0].Y, ED_BY);
+    _feSet(base[0].Z, 1);
+    feMul(base[0].T, ED_BX, ED_BY);
+
+    for (int t = 1; t < COMB_TEETH; t++) {
+        base[t] = base[t - 1];
+        for (int i = 0; i < COMB_SPACING; i++) _double(base[t], base[t]);
+    }
+
+    for (int idx = 0; idx < (1 << COMB_TEETH); idx++) {
+        ExtendedPoint sum;
+        _identity(sum);
+        for (int t = 0; t < COMB_TEETH; t++) {
+            if ((idx >> t) & 1) _add(sum, sum, base[t]);
+        }
+        _toNiels(COMB[idx], sum);
+    }
+
+    P256::initModulus(ORDER, ED_L);
+    P256::montMul(ORDER_R3, ORDER.rr, ORDER.rr, ORDER);
+}
+
+// reads every table entry so the access pattern does not depend on idx
+void Ed25519::_lookup(NielsPoint& r, uint32_t idx) {
+    r = COMB[0];
+
+    for (uint32_t e = 1; e < (1u << COMB_TEETH); e++) {
+        uint64_t mask = 0 - (uint64_t)((((e ^ idx) - 1) >> 31) & 1);
+        _feCmov(r.yPlusX, COMB[e].yPlusX, mask);
+        _feCmov(r.yMinusX, COMB[e].yMinusX, mask);
+        _feCmov(r.xy2d, COMB[e].xy2d, mask);
+    }
+}
+
+void Ed25519::mulBase(ExtendedPoint& r, const unsigned char k[32]) {
+    std::call_once(ED25519_READY, Ed25519::_init);
+
+    ExtendedPoint q;
+    _identity(q);
+
+    for (int i = COMB_SPACING - 1; i >= 0; i--) {
+        _double(q, q);
+
+        uint32_t idx = 0;
+        for (int t = 0; t < COMB_TEETH; t++) {
+            int bit = t * COMB_SPACING + i;
+            if (bit < 256) idx |= ((k[bit / 8] >> (bit % 8)) & 1) << t;
+        }
+
+        NielsPoint entry;
+        _lookup(entry, idx);
+        _addNiels(q, q, entry);
+    }
+
+    r = q;
+}
+
+// y with the sign of x in the top bit
+void Ed25519::encode(unsigned char out[32], const ExtendedPoint& p) {
+    Fe zinv, x, y;
+    unsigned char xb[32];
+
+    feInvert(zinv, p.Z);
+    feMul(x, p.X, zinv);
+    feMul(y, p.Y, zinv);
+    feToBytes(out, y);
+    feToBytes(xb, x);
+    out[31] |= (unsigned char)((xb[0] & 1) << 7);
+}
+
+static void _scalarFromBytes(P256::Int r, const unsigned char* le) {
+    for (int i = 0; i < 8; i++) {
+        const unsigned char* b = le + 4 * i;
+        r[i] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+}
+
+static void _scalarToBytes(unsigned char* le, const P256::Int a) {
+    for (int i = 0; i < 32; i++) le[i] = (unsigned char)(a[i / 4] >> (8 * (i % 4)));
+}
+
+// 64-byte little-endian hash mod L, result in Montgomery form: lo*R + hi*R^2
+static void _scalarReduce(P256::Int r, const unsigned char h[64]) {
+    P256::Int lo, hi;
+
+    _scalarFromBytes(lo, h);
+    _scalarFromBytes(hi, h + 32);
+    P256::montMul(lo, lo, ORDER.rr, ORDER);
+    P256::montMul(hi, hi, ORDER_R3, ORDER);
+    P256::modAdd(r, lo, hi, ORDER);
+}
+
+Ed25519Key::Ed25519Key(std::string& prvKeyPEM) {
+    std::vector<unsigned char> der;
+
+    RSAKey::pemToDER(prvKeyPEM.data(), prvKeyPEM.size(), der);
+    this->_readDER(der.data(), der.size());
+    std::memset(der.data(), 0, der.size());
+    this->_expand();
+}
+
+Ed25519Key::Ed25519Key(const unsigned char* der, size_t len) {
+    this->_readDER(der, len);
+    this->_expand();
+}
+
+Ed25519Key::~Ed25519Key() {
+    volatile unsigned char* p = this->seed;
+    volatile unsigned char* s = this->scalar;
+    volatile unsigned char* x = this->prefix;
+    for (int i = 0; i < 32; i++) p[i] = s[i] = x[i] = 0;
+}
+
+// PKCS#8 (RFC 8410): PrivateKeyInfo { version, { id-Ed25519 }, OCTET STRING { OCTET STRING seed } }
+void Ed25519Key::_readDER(const unsigned char* der, size_t len) {
+    try {
+        DERView top(der, len);
+        if (top.tag != 0x30) throw std::invalid_argument("not a DER SEQUENCE");
+
+        DERView oid = top.child(1).child(0);
+        if (oid.tag != 0x06 || oid.length != sizeof(OID_ED25519) || std::memcmp(oid.value, OID_ED25519, oid.length) != 0) {
+            throw std::invalid_argument("not an Ed25519 key");
+        }
+
+        DERView priv = top.child(2);
+        DERView inner(priv.value, priv.length);
+        if (priv.tag != 0x04 || inner.tag != 0x04 || inner.length != 32) throw std::invalid_argument("bad private key seed");
+
+        std::memcpy(this->seed, inner.value, 32);
+    }
+    catch (std::invalid_argument& e) {
+        throw std::invalid_argument(std::string("malformed Ed25519 private key: ") + e.what());
+    }
+}
+
+void Ed25519Key::_expand() {
+    unsigned char h[64];
+    SHA512 sha;
+
+    sha.update(this->seed, 32);
+    sha.final(h);
+
+    std::memcpy(this->scalar, h, 32);
+    std::memcpy(this->prefix, h + 32, 32);
+    this->scalar[0] &= 248;
+    this->scalar[31] &= 127;
+    this->scalar[31] |= 64;
+    std::memset(h, 0, 64);
+
+    Ed25519::ExtendedPoint a;
+    Ed25519::mulBase(a, this->scalar);
+    Ed25519::encode(this->publicKey, a);
+}
+
+void Ed25519Key::sign(const void* msg, size_t len, unsigned char signature[64]) {
+    const P256::Modulus& L = ORDER;
+    unsigned char h[64], rb[32];
+    P256::Int r, k, a, s;
+    SHA512 sha;
+
+    // r = SHA-512(prefix || M) mod L, R = r*B
+    sha.update(this->prefix, 32);
+    sha.update(msg, len);
+    sha.final(h);
+    _scalarReduce(r, h);
+    P256::fromMont(a, r, L);
+    _scalarToBytes(rb, a);
+
+    Ed25519::ExtendedPoint R;
+    Ed25519::mulBase(R, rb);
+    Ed25519::encode(signature, R);
+
+    // k = SHA-512(R || A || M) mod L
+    sha.update(signature, 32);
+    sha.update(this->publicKey, 32);
+    sha.update(msg, len);
+    sha.final(h);
+    _scalarReduce(k, h);
+
+    // S = r + k*a mod L; the clamped scalar is below 2^255 < R so toMont accepts it
+    _scalarFromBytes(a, this->scalar);
+    P256::toMont(a, a, L);
+    P256::montMul(s, k, a, L);
+    P256::modAdd(s, s, r, L);
+    P256::fromMont(s, s, L);
+    _scalarToBytes(signature + 32, s);
+
+    std::memset(h, 0, 64);
+    std::memset(rb, 0, 32);
+    std::memset(a, 0, sizeof(a));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#ifndef ED25519_H
+#define ED25519_H
+
+// Ed25519 (RFC 8032) group arithmetic. Field elements mod 2^255 - 19 are
+// 5 x 51-bit limbs; points use extended twisted Edwards coordinates and the
+// complete addition law, so the base-point comb has no special cases.
+class Ed25519
+{
+public:
+    typedef uint64_t Fe[5];
+
+    struct ExtendedPoint { Fe X; Fe Y; Fe Z; Fe T; };
+    struct NielsPoint { Fe yPlusX; Fe yMinusX; Fe xy2d; };    // affine, precomputed for mixed addition
+
+    static const int COMB_TEETH = 6;
+    static const int COMB_SPACING = 43;    // COMB_TEETH * COMB_SPACING >= 255
+
+    // k*B through the fixed-base comb table; k is a 32-byte little-endian scalar
+    static void mulBase(ExtendedPoint& r, const unsigned char k[32]);
+    static void encode(unsigned char out[32], const ExtendedPoint& p);
+
+    static void feAdd(Fe r, const Fe a, const Fe b);
+    static void feSub(Fe r, const Fe a, const Fe b);
+    static void feMul(Fe r, const Fe a, const Fe b);
+    static void feSquare(Fe r, const Fe a);
+    static void feInvert(Fe r, const Fe a);
+    static void feToBytes(unsigned char out[32], const Fe a);
+
+private:
+    static void _init();
+    static void _double(ExtendedPoint& r, const ExtendedPoint& p);
+    static void _add(ExtendedPoint& r, const ExtendedPoint& p, const ExtendedPoint& q);
+    static void _addNiels(ExtendedPoint& r, const ExtendedPoint& p, const NielsPoint& q);
+    static void _lookup(NielsPoint& r, uint32_t idx);
+};
+
+// Ed25519 private key from PKCS#8 ("PRIVATE KEY", OID 1.3.101.112)
+class Ed25519Key
+{
+public:
+    unsigned char seed[32];
+    unsigned char publicKey[32];
+
+    Ed25519Key(std::string& prvKeyPEM);
+    Ed25519Key(const unsigned char* der, size_t len);
+    ~Ed25519Key();
+
+    // PureEdDSA over the whole message, 64-byte R || S
+    void sign(const void* msg, size_t len, unsigned char signature[64]);
+
+private:
+    unsigned char scalar[32];   // clamped low half of SHA-512(seed)
+    unsigned char prefix[32];   // high half, keys the nonce
+
+    void _readDER(const unsigned char* der, size_t len);
+    void _expand();
+};
+
+#endif
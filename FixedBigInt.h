@@ -0,0 +1,707 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include "RSALiteCounters.h"
+#include "RSALiteStats.h"
+
+#ifndef FIXEDBIGINT_H
+#define FIXEDBIGINT_H
+
+// Unsigned integers of a width fixed at compile time: Bits / 32 little-endian
+// 32-bit limbs in a std::array, so every loop bound is a constant the compiler
+// can unroll. Covers what the RSA CRT halves need: Montgomery multiply and
+// square (CIOS), reduction of a double-width value, modPow and the plain
+// product for Garner's recombination. Moduli must be odd and below 2^Bits.
+template<int Bits>
+class FixedBigInt
+{
+public:
+    static_assert(Bits % 32 == 0, "FixedBigInt width must be a whole number of 32-bit limbs");
+
+    static const int LIMBS = Bits / 32;
+    typedef std::array<uint32_t, LIMBS> Int;
+    typedef std::array<uint32_t, 2 * LIMBS> Wide;
+
+    // sliding window for modPow, 2^(WINDOW-1) odd powers on the stack
+#ifdef RSALITE_FIXED_LIMBS
+    static const int WINDOW = 4;
+#else
+    static const int WINDOW = 5;
+#endif
+
+    struct Modulus {
+        Int m;
+        uint32_t m0inv;     // -m^-1 mod 2^32
+        Int rr;             // R^2 mod m, R = 2^Bits
+    };
+
+    static void initModulus(Modulus& M, const Int& m) {
+        M.m = m;
+
+        // Newton iteration for m^-1 mod 2^32
+        uint32_t inv = 1;
+        for (int i = 0; i < 5; i++) inv *= 2 - m[0] * inv;
+        M.m0inv = 0 - inv;
+
+        // R^2 mod m by doubling 1 2*Bits times
+        Int x = {};
+        x[0] = 1;
+        for (int i = 0; i < 2 * Bits; i++) modAdd(x, x, x, M);
+        M.rr = x;
+    }
+
+    // big-endian bytes, len <= 4 * N
+    template<size_t N>
+    static void fromBytes(std::array<uint32_t, N>& r, const unsigned char* bytes, size_t len) {
+        r.fill(0);
+        for (size_t i = 0; i < len; i++) {
+            size_t bit = 8 * (len - 1 - i);
+            r[bit / 32] |= (uint32_t)bytes[i] << (bit % 32);
+        }
+    }
+
+    // the low len bytes of a, big-endian
+    template<size_t N>
+    static void toBytes(unsigned char* bytes, size_t len, const std::array<uint32_t, N>& a) {
+        for (size_t i = 0; i < len; i++) {
+            size_t bit = 8 * (len - 1 - i);
+            bytes[i] = bit / 32 < N ? (unsigned char)(a[bit / 32] >> (bit % 32)) : 0;
+        }
+    }
+
+    static int bitLength(const Int& a) {
+        for (int i = LIMBS - 1; i >= 0; i--) {
+            if (a[i] == 0) continue;
+            int bits = 32;
+            while ((a[i] >> (bits - 1)) == 0) bits--;
+            return 32 * i + bits;
+        }
+        return 0;
+    }
+
+    static uint32_t add(Int& r, const Int& a, const Int& b) {
+        uint64_t c = 0;
+        for (int i = 0; i < LIMBS; i++) {
+            c += (uint64_t)a[i] + b[i];
+            r[i] = (uint32_t)c;
+            c >>= 32;
+        }
+        return (uint32_t)c;
+    }
+
+    static uint32_t sub(Int& r, const Int& a, const Int& b) {
+        uint64_t borrow = 0;
+        for (int i = 0; i < LIMBS; i++) {
+            uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+            r[i] = (uint32_t)d;
+            borrow = (d >> 32) & 1;
+        }
+        return (uint32_t)borrow;
+    }
+
+    static void modAdd(Int& r, const Int& a, const Int& b, const Modulus& M) {
+        Int s, u;
+        uint32_t carry = add(s, a, b);
+        uint32_t borrow = sub(u, s, M.m);
+        r = (carry | (borrow ^ 1)) ? u : s;
+    }
+
+    static void modSub(Int& r, const Int& a, const Int& b, const Modulus& M) {
+        Int s, u;
+        uint32_t borrow = sub(s, a, b);
+        add(u, s, M.m);
+        r = borrow ? u : s;
+    }
+
+    // r = a * b, full width
+    static void mul(Wide& r, const Int& a, const Int& b) {
+        RSALITE_COUNT(multiplyTo, 1);
+
+        r.fill(0);
+        for (int i = 0; i < LIMBS; i++) {
+            uint64_t c = 0;
+            for (int j = 0; j < LIMBS; j++) {
+                c += (uint64_t)a[j] * b[i] + r[i + j];
+                r[i + j] = (uint32_t)c;
+                c >>= 32;
+            }
+            r[i + LIMBS] = (uint32_t)c;
+        }
+    }
+
+    // r = a*b/R mod m (CIOS), a*b < m*R
+    static void montMul(Int& r, const Int& a, const Int& b, const Modulus& M) {
+        RSALITE_COUNT(multiplyTo, 1);
+        RSALITE_COUNT(reduce, 1);
+
+        uint32_t t[LIMBS + 2] = {};
+
+        for (int i = 0; i < LIMBS; i++) {
+            uint64_t c = 0;
+            for (int j = 0; j < LIMBS; j++) {
+                c += (uint64_t)a[j] * b[i] + t[j];
+                t[j] = (uint32_t)c;
+                c >>= 32;
+            }
+            c += t[LIMBS];
+            t[LIMBS] = (uint32_t)c;
+            t[LIMBS + 1] = (uint32_t)(c >> 32);
+
+            uint32_t u = t[0] * M.m0inv;
+            c = ((uint64_t)u * M.m[0] + t[0]) >> 32;
+            for (int j = 1; j < LIMBS; j++) {
+                c += (uint64_t)u * M.m[j] + t[j];
+                t[j - 1] = (uint32_t)c;
+                c >>= 32;
+            }
+            c += t[LIMBS];
+            t[LIMBS - 1] = (uint32_t)c;
+            t[LIMBS] = t[LIMBS + 1] + (uint32_t)(c >> 32);
+        }
+
+        _finish(r, t, t[LIMBS], M);
+    }
+
+    // r = a^2/R mod m; the cross products are computed once and doubled
+    static void montSqr(Int& r, const Int& a, const Modulus& M) {
+        RSALITE_COUNT(squareTo, 1);
+        RSALITE_COUNT(reduce, 1);
+
+        uint32_t t[2 * LIMBS + 1] = {};
+
+        for (int i = 0; i < LIMBS - 1; i++) {
+            uint64_t c = 0;
+            for (int j = i + 1; j < LIMBS; j++) {
+                c += (uint64_t)a[i] * a[j] + t[i + j];
+                t[i + j] = (uint32_t)c;
+                c >>= 32;
+            }
+            t[i + LIMBS] = (uint32_t)c;
+        }
+
+        uint32_t top = 0;
+        for (int i = 0; i < 2 * LIMBS; i++) {
+            uint32_t next = t[i] >> 31;
+            t[i] = (t[i] << 1) | top;
+            top = next;
+        }
+
+        uint64_t c = 0;
+        for (int i = 0; i < LIMBS; i++) {
+            c += (uint64_t)a[i] * a[i] + t[2 * i];
+            t[2 * i] = (uint32_t)c;
+            c >>= 32;
+            c += t[2 * i + 1];
+            t[2 * i + 1] = (uint32_t)c;
+            c >>= 32;
+        }
+
+        _redc(r, t, M);
+    }
+
+    // r = x mod m for x of chunks >= 2 Int-sized chunks, Horner from the top:
+    // each step takes the value so far times R and adds the next chunk, which
+    // goes into and back out of Montgomery form
+    static void reduce(Int& r, const uint32_t* x, int chunks, const Modulus& M) {
+        Int acc, c, one = {};
+        std::memcpy(acc.data(), x + (chunks - 1) * LIMBS, sizeof(Int));
+        one[0] = 1;
+
+        for (int i = chunks - 2; i >= 0; i--) {
+            std::memcpy(c.data(), x + i * LIMBS, sizeof(Int));
+            montMul(acc, acc, M.rr, M);     // acc * R mod m
+            montMul(c, c, M.rr, M);         // c * R mod m
+            montMul(c, c, one, M);          // c mod m
+            modAdd(acc, acc, c, M);
+        }
+        r = acc;
+    }
+
+    static void reduce(Int& r, const Wide& x, const Modulus& M) {
+        reduce(r, x.data(), 2, M);
+    }
+
+    // s = s * b + c, truncated to N limbs; the caller keeps it from overflowing
+    template<size_t N>
+    static void mulAdd(std::array<uint32_t, N>& s, const Int& b, const Int& c) {
+        RSALITE_COUNT(multiplyTo, 1);
+
+        std::array<uint32_t, N> t = {};
+        for (size_t i = 0; i < (size_t)LIMBS && i < N; i++) {
+            uint64_t carry = 0;
+            for (size_t j = 0; i + j < N; j++) {
+                carry += (uint64_t)s[j] * b[i] + t[i + j];
+                t[i + j] = (uint32_t)carry;
+                carry >>= 32;
+            }
+        }
+
+        uint64_t carry = 0;
+        for (size_t i = 0; i < N; i++) {
+            carry += (uint64_t)t[i] + (i < (size_t)LIMBS ? c[i] : 0);
+            s[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+    }
+
+    // r = x^e mod m, x < m; sliding window over the odd powers x, x^3, x^5 ...
+    static void modPow(Int& r, const Int& x, const Int& e, const Modulus& M) {
+        Int g[1 << (WINDOW - 1)];
+        Int x2, acc, one = {};
+        one[0] = 1;
+
+        montMul(g[0], x, M.rr, M);
+        montSqr(x2, g[0], M);
+        for (int i = 1; i < (1 << (WINDOW - 1)); i++) montMul(g[i], g[i - 1], x2, M);
+
+        int i = bitLength(e) - 1;
+        bool started = false;
+
+        if (i < 0) {
+            montMul(r, M.rr, one, M);   // R mod m, the Montgomery form of 1
+            montMul(r, r, one, M);
+            return;
+        }
+
+        while (i >= 0) {
+            if (!_bit(e, i)) {
+                montSqr(acc, acc, M);
+                i--;
+                continue;
+            }
+
+            // the longest window starting at bit i that ends on a set bit
+            int l = i - WINDOW + 1 < 0 ? 0 : i - WINDOW + 1;
+            while (!_bit(e, l)) l++;
+
+            int w = 0;
+            for (int k = i; k >= l; k--) w = (w << 1) | _bit(e, k);
+
+            if (started) {
+                for (int k = i; k >= l; k--) montSqr(acc, acc, M);
+                montMul(acc, acc, g[w >> 1], M);
+            }
+            else {
+                acc = g[w >> 1];
+                started = true;
+            }
+            i = l - 1;
+        }
+
+        montMul(r, acc, one, M);
+    }
+
+    // Two independent montMul in one loop body: the carry chains of the two
+    // lanes do not depend on each other, so the core overlaps them
+    static void montMul2(Int& r1, const Int& a1, const Int& b1, const Modulus& M1,
+        Int& r2, const Int& a2, const Int& b2, const Modulus& M2) {
+        RSALITE_COUNT(multiplyTo, 2);
+        RSALITE_COUNT(reduce, 2);
+
+        uint32_t t1[LIMBS + 2] = {}, t2[LIMBS + 2] = {};
+
+        for (int i = 0; i < LIMBS; i++) {
+            uint64_t c1 = 0, c2 = 0;
+            for (int j = 0; j < LIMBS; j++) {
+                c1 += (uint64_t)a1[j] * b1[i] + t1[j];
+                c2 += (uint64_t)a2[j] * b2[i] + t2[j];
+                t1[j] = (uint32_t)c1;
+                t2[j] = (uint32_t)c2;
+                c1 >>= 32;
+                c2 >>= 32;
+            }
+            c1 += t1[LIMBS];
+            c2 += t2[LIMBS];
+            t1[LIMBS] = (uint32_t)c1;
+            t2[LIMBS] = (uint32_t)c2;
+            t1[LIMBS + 1] = (uint32_t)(c1 >> 32);
+            t2[LIMBS + 1] = (uint32_t)(c2 >> 32);
+
+            uint32_t u1 = t1[0] * M1.m0inv, u2 = t2[0] * M2.m0inv;
+            c1 = ((uint64_t)u1 * M1.m[0] + t1[0]) >> 32;
+            c2 = ((uint64_t)u2 * M2.m[0] + t2[0]) >> 32;
+            for (int j = 1; j < LIMBS; j++) {
+                c1 += (uint64_t)u1 * M1.m[j] + t1[j];
+                c2 += (uint64_t)u2 * M2.m[j] + t2[j];
+                t1[j - 1] = (uint32_t)c1;
+                t2[j - 1] = (uint32_t)c2;
+                c1 >>= 32;
+                c2 >>= 32;
+            }
+            c1 += t1[LIMBS];
+            c2 += t2[LIMBS];
+            t1[LIMBS - 1] = (uint32_t)c1;
+            t2[LIMBS - 1] = (uint32_t)c2;
+            t1[LIMBS] = t1[LIMBS + 1] + (uint32_t)(c1 >> 32);
+            t2[LIMBS] = t2[LIMBS + 1] + (uint32_t)(c2 >> 32);
+        }
+
+        _finish(r1, t1, t1[LIMBS], M1);
+        _finish(r2, t2, t2[LIMBS], M2);
+    }
+
+    // montSqr on two lanes, interleaved like montMul2
+    static void montSqr2(Int& r1, const Int& a1, const Modulus& M1, Int& r2, const Int& a2, const Modulus& M2) {
+        RSALITE_COUNT(squareTo, 2);
+        RSALITE_COUNT(reduce, 2);
+
+        uint32_t t1[2 * LIMBS + 1] = {}, t2[2 * LIMBS + 1] = {};
+
+        for (int i = 0; i < LIMBS - 1; i++) {
+            uint64_t c1 = 0, c2 = 0;
+            for (int j = i + 1; j < LIMBS; j++) {
+                c1 += (uint64_t)a1[i] * a1[j] + t1[i + j];
+                c2 += (uint64_t)a2[i] * a2[j] + t2[i + j];
+                t1[i + j] = (uint32_t)c1;
+                t2[i + j] = (uint32_t)c2;
+                c1 >>= 32;
+                c2 >>= 32;
+            }
+            t1[i + LIMBS] = (uint32_t)c1;
+            t2[i + LIMBS] = (uint32_t)c2;
+        }
+
+        uint32_t top1 = 0, top2 = 0;
+        for (int i = 0; i < 2 * LIMBS; i++) {
+            uint32_t next1 = t1[i] >> 31, next2 = t2[i] >> 31;
+            t1[i] = (t1[i] << 1) | top1;
+            t2[i] = (t2[i] << 1) | top2;
+            top1 = next1;
+            top2 = next2;
+        }
+
+        uint64_t c1 = 0, c2 = 0;
+        for (int i = 0; i < LIMBS; i++) {
+            c1 += (uint64_t)a1[i] * a1[i] + t1[2 * i];
+            c2 += (uint64_t)a2[i] * a2[i] + t2[2 * i];
+            t1[2 * i] = (uint32_t)c1;
+            t2[2 * i] = (uint32_t)c2;
+            c1 >>= 32;
+            c2 >>= 32;
+            c1 += t1[2 * i + 1];
+            c2 += t2[2 * i + 1];
+            t1[2 * i + 1] = (uint32_t)c1;
+            t2[2 * i + 1] = (uint32_t)c2;
+            c1 >>= 32;
+            c2 >>= 32;
+        }
+
+        _redc2(r1, t1, M1, r2, t2, M2);
+    }
+
+    // modPow on two lanes in lockstep: both square at every bit of the longer
+    // exponent, and multiply by their sliding-window power where a window of
+    // that lane ends, paired when the two lanes' windows end together
+    static void modPow2(Int& r1, const Int& x1, const Int& e1, const Modulus& M1,
+        Int& r2, const Int& x2, const Int& e2, const Modulus& M2) {
+        Int g1[1 << (WINDOW - 1)], g2[1 << (WINDOW - 1)];
+        Int sq1, sq2, acc1, acc2, one = {};
+        one[0] = 1;
+
+        montMul2(g1[0], x1, M1.rr, M1, g2[0], x2, M2.rr, M2);
+        montSqr2(sq1, g1[0], M1, sq2, g2[0], M2);
+        for (int i = 1; i < (1 << (WINDOW - 1)); i++) montMul2(g1[i], g1[i - 1], sq1, M1, g2[i], g2[i - 1], sq2, M2);
+
+        montMul2(acc1, M1.rr, one, M1, acc2, M2.rr, one, M2);     // R mod m, 1 in Montgomery form
+
+        int top = std::max(bitLength(e1), bitLength(e2)) - 1;
+        int l1 = -1, w1 = 0, l2 = -1, w2 = 0;
+        _window(e1, top, l1, w1);
+        _window(e2, top, l2, w2);
+
+        for (int k = top; k >= 0; k--) {
+            montSqr2(acc1, acc1, M1, acc2, acc2, M2);
+
+            if (k == l1 && k == l2) montMul2(acc1, acc1, g1[w1 >> 1], M1, acc2, acc2, g2[w2 >> 1], M2);
+            else if (k == l1) montMul(acc1, acc1, g1[w1 >> 1], M1);
+            else if (k == l2) montMul(acc2, acc2, g2[w2 >> 1], M2);
+
+            if (k == l1) _window(e1, k - 1, l1, w1);
+            if (k == l2) _window(e2, k - 1, l2, w2);
+        }
+
+        montMul2(r1, acc1, one, M1, r2, acc2, one, M2);
+    }
+
+private:
+    static int _bit(const Int& e, int i) {
+        return (e[i / 32] >> (i % 32)) & 1;
+    }
+
+    // Montgomery reduction of a 2 * LIMBS product in t (one limb of headroom)
+    static void _redc(Int& r, uint32_t* t, const Modulus& M) {
+        for (int i = 0; i < LIMBS; i++) {
+            uint32_t u = t[i] * M.m0inv;
+            uint64_t c = 0;
+            for (int j = 0; j < LIMBS; j++) {
+                c += (uint64_t)u * M.m[j] + t[i + j];
+                t[i + j] = (uint32_t)c;
+                c >>= 32;
+            }
+            for (int k = i + LIMBS; c != 0 && k <= 2 * LIMBS; k++) {
+                c += t[k];
+                t[k] = (uint32_t)c;
+                c >>= 32;
+            }
+        }
+
+        _finish(r, t + LIMBS, t[2 * LIMBS], M);
+    }
+
+    // _redc on two lanes, interleaved like montMul2
+    static void _redc2(Int& r1, uint32_t* t1, const Modulus& M1, Int& r2, uint32_t* t2, const Modulus& M2) {
+        for (int i = 0; i < LIMBS; i++) {
+            uint32_t u1 = t1[i] * M1.m0inv, u2 = t2[i] * M2.m0inv;
+            uint64_t c1 = 0, c2 = 0;
+            for (int j = 0; j < LIMBS; j++) {
+                c1 += (uint64_t)u1 * M1.m[j] + t1[i + j];
+                c2 += (uint64_t)u2 * M2.m[j] + t2[i + j];
+                t1[i + j] = (uint32_t)c1;
+                t2[i + j] = (uint32_t)c2;
+                c1 >>= 32;
+                c2 >>= 32;
+            }
+            for (int k = i + LIMBS; c1 != 0 && k <= 2 * LIMBS; k++) {
+                c1 += t1[k];
+                t1[k] = (uint32_t)c1;
+                c1 >>= 32;
+            }
+            for (int k = i + LIMBS; c2 != 0 && k <= 2 * LIMBS; k++) {
+                c2 += t2[k];
+                t2[k] = (uint32_t)c2;
+                c2 >>= 32;
+            }
+        }
+
+        _finish(r1, t1 + LIMBS, t1[2 * LIMBS], M1);
+        _finish(r2, t2 + LIMBS, t2[2 * LIMBS], M2);
+    }
+
+    // The next sliding window at or below bit i: its lowest bit l and odd
+    // value w; l is -1 once no set bit is left
+    static void _window(const Int& e, int i, int& l, int& w) {
+        while (i >= 0 && !_bit(e, i)) i--;
+        l = -1;
+        if (i < 0) return;
+
+        l = i - WINDOW + 1 < 0 ? 0 : i - WINDOW + 1;
+        while (!_bit(e, l)) l++;
+
+        w = 0;
+        for (int k = i; k >= l; k--) w = (w << 1) | _bit(e, k);
+    }
+
+    // r = t - m if t (plus the carry limb above it) >= m, else t; t < 2m
+    static void _finish(Int& r, const uint32_t* t, uint32_t carry, const Modulus& M) {
+        Int v, u;
+        std::memcpy(v.data(), t, sizeof(Int));
+        uint32_t borrow = sub(u, v, M.m);
+        r = (carry | (borrow ^ 1)) ? u : v;
+    }
+};
+
+class RSAKey;
+class RSAPublicKey;
+
+// The RSA CRT private operation at a compile-time width, picked once by
+// RSAKey::prepare(). create() returns NULL when the primes fit no width, or
+// there are more than MAX_PRIMES of them, and the key keeps using the dynamic
+// BigInteger path.
+class RSAFixedSigner
+{
+public:
+    static const int MAX_PRIMES = 4;
+
+    virtual ~RSAFixedSigner() {}
+
+    // em, the k-byte encoded message, is replaced by em^d mod n
+    virtual void sign(unsigned char* em, size_t k, RSALiteStageClock& clock) const = 0;
+
+    // a blinding pair as residues in Garner order: r^e and r^-1 mod each
+    // prime, big-endian, bits() / 8 bytes each
+    virtual void setBlinding(const unsigned char* values) = 0;
+
+    virtual int bits() const = 0;
+
+    static RSAFixedSigner* create(RSAKey& key);
+};
+
+// The primes are taken in Garner order q, p, r_3 ... (RFC 8017 5.1.2): the
+// signature is the mixed-radix number v_0 + q * (v_1 + p * (v_2 + r_3 * ...))
+// whose digits come from the residues, one prime after the other
+template<int Bits>
+class RSAFixedSignerOf : public RSAFixedSigner
+{
+public:
+    typedef FixedBigInt<Bits> F;
+    typedef std::array<uint32_t, MAX_PRIMES * F::LIMBS> Message;
+
+    // count triples of big-endian prime, exponent d mod (prime - 1) and
+    // coefficient (product of the primes before it)^-1 mod prime, Bits / 8
+    // bytes each; the first prime has no coefficient and its bytes are ignored
+    RSAFixedSignerOf(int count, const unsigned char* values) : count(count) {
+        typename F::Int v, one = {};
+        one[0] = 1;
+
+        for (int i = 0; i < count; i++) {
+            const unsigned char* prime = values + 3 * i * (Bits / 8);
+
+            F::fromBytes(v, prime, Bits / 8);
+            F::initModulus(this->M[i], v);
+            F::fromBytes(this->d[i], prime + Bits / 8, Bits / 8);
+
+            // the coefficient and the products of the earlier primes in
+            // Montgomery form, so one montMul applies each
+            F::fromBytes(v, prime + 2 * (Bits / 8), Bits / 8);
+            F::montMul(this->cR[i], v, this->M[i].rr, this->M[i]);
+            F::montMul(this->radixR[i][0], this->M[i].rr, one, this->M[i]);
+            for (int j = 1; j < i; j++) {
+                F::montMul(v, this->radixR[i][j - 1], this->M[j - 1].m, this->M[i]);
+                F::montMul(this->radixR[i][j], v, this->M[i].rr, this->M[i]);
+            }
+        }
+    }
+
+    void sign(unsigned char* em, size_t k, RSALiteStageClock& clock) const override {
+        Message x;
+        typename F::Int v[MAX_PRIMES], h, blind[MAX_PRIMES], unblind[MAX_PRIMES];
+
+        this->_nextBlinding(blind, unblind);
+
+        // the residues are blinded by r^e on the way in, and the r that comes
+        // out of the exponentiation is taken off again by r^-1
+        F::fromBytes(x, em, k);
+        for (int i = 0; i < this->count; i++) {
+            F::reduce(v[i], x.data(), (int)((8 * k + Bits - 1) / Bits), this->M[i]);
+            F::montMul(v[i], v[i], blind[i], this->M[i]);
+        }
+
+        // the chains run interleaved in pairs; the stage clock can only see a
+        // pair together, so EXP_P holds every exponentiation and EXP_Q stays empty
+        int i = 0;
+        for (; i + 1 < this->count; i += 2) {
+            F::modPow2(v[i], v[i], this->d[i], this->M[i], v[i + 1], v[i + 1], this->d[i + 1], this->M[i + 1]);
+        }
+        if (i < this->count) F::modPow(v[i], v[i], this->d[i], this->M[i]);
+        for (int i = 0; i < this->count; i++) F::montMul(v[i], v[i], unblind[i], this->M[i]);
+        clock.lap(STAGE_EXP_P);
+
+        // digit i = (residue i - the digits before it, mod prime i) * coefficient i
+        for (int i = 1; i < this->count; i++) {
+            for (int j = 0; j < i; j++) {
+                F::montMul(h, v[j], this->radixR[i][j], this->M[i]);
+                F::modSub(v[i], v[i], h, this->M[i]);
+            }
+            F::montMul(v[i], v[i], this->cR[i], this->M[i]);
+        }
+
+        Message s = {};
+        std::memcpy(s.data(), v[this->count - 1].data(), sizeof(h));
+        for (int j = this->count - 2; j >= 0; j--) F::mulAdd(s, this->M[j].m, v[j]);
+
+        F::toBytes(em, k, s);
+        clock.lap(STAGE_RECOMBINE);
+    }
+
+    void setBlinding(const unsigned char* values) override {
+        typename F::Int v;
+        std::lock_guard<std::mutex> guard(this->blindingLock);
+
+        for (int i = 0; i < this->count; i++) {
+            F::fromBytes(v, values + 2 * i * (Bits / 8), Bits / 8);
+            F::montMul(this->blindR[i], v, this->M[i].rr, this->M[i]);
+            F::fromBytes(v, values + (2 * i + 1) * (Bits / 8), Bits / 8);
+            F::montMul(this->unblindR[i], v, this->M[i].rr, this->M[i]);
+        }
+    }
+
+    int bits() const override {
+        return Bits;
+    }
+
+private:
+    int count;
+    typename F::Modulus M[MAX_PRIMES];
+    typename F::Int d[MAX_PRIMES];
+    typename F::Int cR[MAX_PRIMES];
+    typename F::Int radixR[MAX_PRIMES][MAX_PRIMES];    // [i][j]: product of the primes before j, times R, mod prime i
+
+    // the blinding pair in Montgomery form, so one montMul applies either;
+    // squaring both after a use turns (r^e, r^-1) into ((r^2)^e, r^-2)
+    mutable std::mutex blindingLock;
+    mutable typename F::Int blindR[MAX_PRIMES];
+    mutable typename F::Int unblindR[MAX_PRIMES];
+
+    void _nextBlinding(typename F::Int* blind, typename F::Int* unblind) const {
+        std::lock_guard<std::mutex> guard(this->blindingLock);
+
+        for (int i = 0; i < this->count; i++) {
+            blind[i] = this->blindR[i];
+            unblind[i] = this->unblindR[i];
+            F::montSqr(this->blindR[i], this->blindR[i], this->M[i]);
+            F::montSqr(this->unblindR[i], this->unblindR[i], this->M[i]);
+        }
+    }
+};
+
+// The RSA public operation at a compile-time width, picked once by
+// RSAPublicKey::prepare(); NULL for moduli no width covers
+class RSAFixedVerifier
+{
+public:
+    virtual ~RSAFixedVerifier() {}
+
+    // em, k bytes below n, is replaced by em^e mod n
+    virtual void verify(unsigned char* em, size_t k, int e) const = 0;
+
+    virtual int bits() const = 0;
+
+    static RSAFixedVerifier* create(RSAPublicKey& key);
+};
+
+template<int Bits>
+class RSAFixedVerifierOf : public RSAFixedVerifier
+{
+public:
+    typedef FixedBigInt<Bits> F;
+
+    // big-endian modulus, Bits / 8 bytes
+    RSAFixedVerifierOf(const unsigned char* modulus) {
+        typename F::Int n;
+        F::fromBytes(n, modulus, Bits / 8);
+        F::initModulus(this->M, n);
+    }
+
+    void verify(unsigned char* em, size_t k, int e) const override {
+        typename F::Int x, y;
+        F::fromBytes(x, em, k);
+
+        if (e == 65537) {
+            // x^65536 R after 16 squarings in Montgomery form; the multiply by
+            // the plain x drops the R again
+            F::montMul(y, x, this->M.rr, this->M);
+            for (int i = 0; i < 16; i++) F::montSqr(y, y, this->M);
+            F::montMul(y, y, x, this->M);
+        }
+        else {
+            typename F::Int exponent = {};
+            exponent[0] = (uint32_t)e;
+            F::modPow(y, x, exponent, this->M);
+        }
+
+        F::toBytes(em, k, y);
+    }
+
+    int bits() const override {
+        return Bits;
+    }
+
+private:
+    typename F::Modulus M;
+};
+
+#endif
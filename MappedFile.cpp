@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <algorithm>
+
+#ifdef RSALITE_HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#elif defined(_WIN32) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#include <filesystem>
+#define RSALITE_HAVE_FILESYSTEM 1
+#endif
+
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const std::string& path) {
+    this->open(path);
+}
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    this->close();
+
+#ifdef RSALITE_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0) {
+        void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+
+        madvise(m, st.st_size, MADV_SEQUENTIAL);
+        this->mapping = m;
+        this->data = (const unsigned char*)m;
+    }
+
+    this->size = st.st_size;
+    ::close(fd);
+
+    return true;
+#else
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) return false;
+
+    in.seekg(0, std::ios::end);
+    std::streamoff len = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (len < 0) return false;
+
+    this->buffer.resize((size_t)len);
+    if (len > 0 && !in.read((char*)this->buffer.data(), len)) {
+        this->buffer.clear();
+        return false;
+    }
+
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef RSALITE_HAVE_MMAP
+    if (this->mapping != NULL) munmap(this->mapping, this->size);
+#endif
+    this->mapping = NULL;
+    this->buffer.clear();
+    this->data = NULL;
+    this->size = 0;
+}
+
+// Regular, non-hidden files directly inside path, sorted by name
+bool MappedFile::listDirectory(const std::string& path, std::vector<std::string>& files) {
+#ifdef RSALITE_HAVE_MMAP
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL) return false;
+
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.') continue;
+
+        std::string full = path + "/" + ent->d_name;
+        struct stat st;
+        if (stat(full.c_str(), &st) == 0 && S_ISREG(st.st_mode)) files.push_back(full);
+    }
+    closedir(dir);
+#elif defined(RSALITE_HAVE_FILESYSTEM)
+    std::error_code ec;
+    for (const auto& ent : std::filesystem::directory_iterator(path, ec)) {
+        std::string name = ent.path().filename().string();
+        if (name.empty() || name[0] == '.' || !ent.is_regular_file()) continue;
+        files.push_back(ent.path().string());
+    }
+    if (ec) return false;
+#else
+    return false;
+#endif
+
+    std::sort(files.begin(), files.end());
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RSALITE_HAVE_MMAP 1
+#endif
+
+// Read-only view of a whole file, mmapped where the platform allows it
+// and read into memory otherwise
+class MappedFile
+{
+public:
+    const unsigned char* data = NULL;
+    size_t size = 0;
+
+    MappedFile();
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    static bool listDirectory(const std::string& path, std::vector<std::string>& files);
+
+private:
+    void* mapping = NULL;
+    std::vector<unsigned char> buffer;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+#endif
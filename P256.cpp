@@ -0,0 +1,541 @@
+#include "P256.h"
+#include "RSALite.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+static P256::Modulus FIELD;
+static P256::Modulus ORDER;
+static P256::AffinePoint COMB[1 << P256::COMB_TEETH];
+static std::once_flag P256_READY;
+
+// big-endian hex of p, n and G
+static const char* P256_P = "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff";
+static const char* P256_N = "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551";
+static const char* P256_GX = "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296";
+static const char* P256_GY = "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5";
+
+// prime256v1 and id-ecPublicKey OIDs, DER values
+static const unsigned char OID_PRIME256V1[] = { 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07 };
+static const unsigned char OID_EC_PUBLIC_KEY[] = { 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01 };
+
+static void _hexToInt(P256::Int r, const char* hex) {
+    unsigned char bytes[32];
+    for (int i = 0; i < 32; i++) {
+        unsigned int v;
+        std::sscanf(hex + 2 * i, "%2x", &v);
+        bytes[i] = (unsigned char)v;
+    }
+    P256::fromBytes(r, bytes);
+}
+
+static uint32_t _addRaw(P256::Int r, const P256::Int a, const P256::Int b) {
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    return (uint32_t)c;
+}
+
+static uint32_t _subRaw(P256::Int r, const P256::Int a, const P256::Int b) {
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c = (uint64_t)a[i] - b[i] - c;
+        r[i] = (uint32_t)c;
+        c = (c >> 32) & 1;
+    }
+    return (uint32_t)c;
+}
+
+// r = mask ? a : r, mask all ones or zero
+static void _cmov(P256::Int r, const P256::Int a, uint32_t mask) {
+    for (int i = 0; i < 8; i++) r[i] = (r[i] & ~mask) | (a[i] & mask);
+}
+
+static void _copy(P256::Int r, const P256::Int a) {
+    std::memcpy(r, a, sizeof(P256::Int));
+}
+
+void P256::initModulus(Modulus& M, const Int m) {
+    _copy(M.m, m);
+
+    // Newton iteration for m^-1 mod 2^32
+    uint32_t inv = 1;
+    for (int i = 0; i < 5; i++) inv *= 2 - M.m[0] * inv;
+    M.m0inv = 0 - inv;
+
+    // R mod m and R^2 mod m by doubling 1 512 times
+    Int x = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 512; i++) {
+        modAdd(x, x, x, M);
+        if (i == 255) _copy(M.one, x);
+    }
+    _copy(M.rr, x);
+}
+
+void P256::_init() {
+    Int m;
+    _hexToInt(m, P256_P);
+    initModulus(FIELD, m);
+    _hexToInt(m, P256_N);
+    initModulus(ORDER, m);
+
+    // COMB[idx] = sum of 2^(SPACING * t) * G over the set bits t of idx
+    AffinePoint base[COMB_TEETH];
+    Int gx, gy;
+    _hexToInt(gx, P256_GX);
+    _hexToInt(gy, P256_GY);
+    toMont(base[0].x, gx, FIELD);
+    toMont(base[0].y, gy, FIELD);
+
+    for (int t = 1; t < COMB_TEETH; t++) {
+        JacobianPoint j;
+        _copy(j.X, base[t - 1].x);
+        _copy(j.Y, base[t - 1].y);
+        _copy(j.Z, FIELD.one);
+        for (int i = 0; i < COMB_SPACING; i++) _double(j, j);
+        toAffine(base[t], j);
+    }
+
+    std::memset(COMB, 0, sizeof(COMB));
+    for (int idx = 1; idx < (1 << COMB_TEETH); idx++) {
+        int high = 0;
+        while ((idx >> (high + 1)) != 0) high++;
+
+        int rest = idx & ~(1 << high);
+        if (rest == 0) {
+            COMB[idx] = base[high];
+            continue;
+        }
+
+        JacobianPoint j;
+        _copy(j.X, COMB[rest].x);
+        _copy(j.Y, COMB[rest].y);
+        _copy(j.Z, FIELD.one);
+        _addAffine(j, j, base[high], 0);
+        toAffine(COMB[idx], j);
+    }
+}
+
+const P256::Modulus& P256::fieldModulus() {
+    std::call_once(P256_READY, P256::_init);
+    return FIELD;
+}
+
+const P256::Modulus& P256::orderModulus() {
+    std::call_once(P256_READY, P256::_init);
+    return ORDER;
+}
+
+void P256::fromBytes(Int r, const unsigned char bytes[32]) {
+    for (int i = 0; i < 8; i++) {
+        const unsigned char* b = bytes + 28 - 4 * i;
+        r[i] = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+    }
+}
+
+void P256::toBytes(unsigned char bytes[32], const Int a) {
+    for (int i = 0; i < 8; i++) {
+        unsigned char* b = bytes + 28 - 4 * i;
+        b[0] = (unsigned char)(a[i] >> 24);
+        b[1] = (unsigned char)(a[i] >> 16);
+        b[2] = (unsigned char)(a[i] >> 8);
+        b[3] = (unsigned char)a[i];
+    }
+}
+
+// r = a*b/R mod m (CIOS), inputs < m
+void P256::montMul(Int r, const Int a, const Int b, const Modulus& M) {
+    uint32_t t[10] = { 0 };
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t c = 0;
+        for (int j = 0; j < 8; j++) {
+            c += (uint64_t)a[j] * b[i] + t[j];
+            t[j] = (uint32_t)c;
+            c >>= 32;
+        }
+        c += t[8];
+        t[8] = (uint32_t)c;
+        t[9] = (uint32_t)(c >> 32);
+
+        uint32_t u = t[0] * M.m0inv;
+        c = ((uint64_t)u * M.m[0] + t[0]) >> 32;
+        for (int j = 1; j < 8; j++) {
+            c += (uint64_t)u * M.m[j] + t[j];
+            t[j - 1] = (uint32_t)c;
+            c >>= 32;
+        }
+        c += t[8];
+        t[7] = (uint32_t)c;
+        t[8] = t[9] + (uint32_t)(c >> 32);
+    }
+
+    // t < 2m, subtract m once if t >= m
+    Int u;
+    uint32_t borrow = _subRaw(u, t, M.m);
+    uint32_t mask = 0 - (t[8] | (borrow ^ 1));
+    _copy(r, t);
+    _cmov(r, u, mask);
+}
+
+void P256::modAdd(Int r, const Int a, const Int b, const Modulus& M) {
+    Int s, u;
+    uint32_t carry = _addRaw(s, a, b);
+    uint32_t borrow = _subRaw(u, s, M.m);
+    uint32_t mask = 0 - (carry | (borrow ^ 1));
+    _cmov(s, u, mask);
+    _copy(r, s);
+}
+
+void P256::modSub(Int r, const Int a, const Int b, const Modulus& M) {
+    Int s, u;
+    uint32_t borrow = _subRaw(s, a, b);
+    _addRaw(u, s, M.m);
+    _cmov(s, u, 0 - borrow);
+    _copy(r, s);
+}
+
+void P256::toMont(Int r, const Int a, const Modulus& M) {
+    montMul(r, a, M.rr, M);
+}
+
+void P256::fromMont(Int r, const Int a, const Modulus& M) {
+    const Int one = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    montMul(r, a, one, M);
+}
+
+// a^(m-2) in Montgomery form; the exponent is public so plain square-and-multiply is constant time
+void P256::modInv(Int r, const Int a, const Modulus& M) {
+    const Int two = { 2, 0, 0, 0, 0, 0, 0, 0 };
+    Int e, x;
+    _subRaw(e, M.m, two);
+    _copy(x, M.one);
+
+    for (int i = 255; i >= 0; i--) {
+        montMul(x, x, x, M);
+        if ((e[i / 32] >> (i % 32)) & 1) montMul(x, x, a, M);
+    }
+    _copy(r, x);
+}
+
+uint32_t P256::isZero(const Int a) {
+    uint32_t acc = 0;
+    for (int i = 0; i < 8; i++) acc |= a[i];
+    return 0 - (uint32_t)(((uint64_t)acc - 1) >> 63);
+}
+
+int P256::compare(const Int a, const Int b) {
+    for (int i = 7; i >= 0; i--) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// dbl-2001-b, a = -3
+void P256::_double(JacobianPoint& r, const JacobianPoint& p) {
+    const Modulus& F = FIELD;
+    Int delta, gamma, beta, alpha, t0, t1;
+
+    montMul(delta, p.Z, p.Z, F);
+    montMul(gamma, p.Y, p.Y, F);
+    montMul(beta, p.X, gamma, F);
+
+    modSub(t0, p.X, delta, F);
+    modAdd(t1, p.X, delta, F);
+    montMul(alpha, t0, t1, F);
+    modAdd(t0, alpha, alpha, F);
+    modAdd(alpha, t0, alpha, F);
+
+    // Z3 = (Y + Z)^2 - gamma - delta
+    modAdd(t0, p.Y, p.Z, F);
+    montMul(t0, t0, t0, F);
+    modSub(t0, t0, gamma, F);
+    modSub(r.Z, t0, delta, F);
+
+    // X3 = alpha^2 - 8 beta
+    modAdd(beta, beta, beta, F);
+    modAdd(beta, beta, beta, F);    // 4 beta
+    montMul(t0, alpha, alpha, F);
+    modSub(t0, t0, beta, F);
+    modSub(r.X, t0, beta, F);
+
+    // Y3 = alpha (4 beta - X3) - 8 gamma^2
+    modSub(t0, beta, r.X, F);
+    montMul(t0, alpha, t0, F);
+    montMul(t1, gamma, gamma, F);
+    modAdd(t1, t1, t1, F);
+    modAdd(t1, t1, t1, F);
+    modAdd(t1, t1, t1, F);
+    modSub(r.Y, t0, t1, F);
+}
+
+// madd-2007-bl with the point-at-infinity cases resolved by constant-time selects.
+// p == q is not handled; the comb never reaches it for scalars below n.
+void P256::_addAffine(JacobianPoint& r, const JacobianPoint& p, const AffinePoint& q, uint32_t qIsInfinity) {
+    const Modulus& F = FIELD;
+    Int z1z1, u2, s2, h, hh, i, j, rr, v, t0;
+    JacobianPoint out;
+    uint32_t pIsInfinity = isZero(p.Z);
+
+    montMul(z1z1, p.Z, p.Z, F);
+    montMul(u2, q.x, z1z1, F);
+    montMul(s2, q.y, p.Z, F);
+    montMul(s2, s2, z1z1, F);
+
+    modSub(h, u2, p.X, F);
+    montMul(hh, h, h, F);
+    modAdd(i, hh, hh, F);
+    modAdd(i, i, i, F);
+    montMul(j, h, i, F);
+    modSub(rr, s2, p.Y, F);
+    modAdd(rr, rr, rr, F);
+    montMul(v, p.X, i, F);
+
+    // X3 = r^2 - J - 2V
+    montMul(t0, rr, rr, F);
+    modSub(t0, t0, j, F);
+    modSub(t0, t0, v, F);
+    modSub(out.X, t0, v, F);
+
+    // Y3 = r (V - X3) - 2 Y1 J
+    modSub(t0, v, out.X, F);
+    montMul(t0, rr, t0, F);
+    montMul(j, p.Y, j, F);
+    modAdd(j, j, j, F);
+    modSub(out.Y, t0, j, F);
+
+    // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+    modAdd(t0, p.Z, h, F);
+    montMul(t0, t0, t0, F);
+    modSub(t0, t0, z1z1, F);
+    modSub(out.Z, t0, hh, F);
+
+    _cmov(out.X, q.x, pIsInfinity);
+    _cmov(out.Y, q.y, pIsInfinity);
+    _cmov(out.Z, F.one, pIsInfinity);
+
+    _cmov(out.X, p.X, qIsInfinity);
+    _cmov(out.Y, p.Y, qIsInfinity);
+    _cmov(out.Z, p.Z, qIsInfinity);
+
+    r = out;
+}
+
+// reads every table entry so the access pattern does not depend on idx
+void P256::_lookup(AffinePoint& r, uint32_t idx) {
+    std::memset(&r, 0, sizeof(r));
+
+    for (uint32_t e = 1; e < (1u << COMB_TEETH); e++) {
+        uint32_t mask = 0 - (((e ^ idx) - 1) >> 31);
+        _cmov(r.x, COMB[e].x, mask);
+        _cmov(r.y, COMB[e].y, mask);
+    }
+}
+
+void P256::mulBase(JacobianPoint& r, const Int k) {
+    std::call_once(P256_READY, P256::_init);
+
+    JacobianPoint q;
+    _copy(q.X, FIELD.one);
+    _copy(q.Y, FIELD.one);
+    std::memset(q.Z, 0, sizeof(q.Z));
+
+    for (int i = COMB_SPACING - 1; i >= 0; i--) {
+        _double(q, q);
+
+        uint32_t idx = 0;
+        for (int t = 0; t < COMB_TEETH; t++) {
+            int bit = t * COMB_SPACING + i;
+            if (bit < 256) idx |= ((k[bit / 32] >> (bit % 32)) & 1) << t;
+        }
+
+        AffinePoint entry;
+        _lookup(entry, idx);
+        _addAffine(q, q, entry, 0 - ((idx - 1) >> 31));
+    }
+
+    r = q;
+}
+
+void P256::toAffine(AffinePoint& r, const JacobianPoint& p) {
+    const Modulus& F = FIELD;
+    Int zinv, z2;
+
+    modInv(zinv, p.Z, F);
+    montMul(z2, zinv, zinv, F);
+    montMul(r.x, p.X, z2, F);
+    montMul(z2, z2, zinv, F);
+    montMul(r.y, p.Y, z2, F);
+}
+
+ECKey::ECKey(std::string& prvKeyPEM) {
+    std::vector<unsigned char> der;
+
+    RSAKey::pemToDER(prvKeyPEM.data(), prvKeyPEM.size(), der);
+    this->_readDER(der.data(), der.size());
+    std::memset(der.data(), 0, der.size());
+}
+
+ECKey::ECKey(const unsigned char* der, size_t len) {
+    this->_readDER(der, len);
+}
+
+ECKey::~ECKey() {
+    volatile unsigned char* p = this->d;
+    for (int i = 0; i < 32; i++) p[i] = 0;
+}
+
+void ECKey::_readDER(const unsigned char* der, size_t len) {
+    try {
+        DERView top(der, len);
+        if (top.tag != 0x30) throw std::invalid_argument("not a DER SEQUENCE");
+
+        DERView second = top.child(1);
+        if (second.tag == 0x04) {	// SEC1 ECPrivateKey
+            this->_readECPrivateKey(der, len);
+            return;
+        }
+
+        // PKCS#8 PrivateKeyInfo with id-ecPublicKey / prime256v1
+        DERView algOid = second.child(0);
+        DERView curveOid = second.child(1);
+        if (algOid.length != sizeof(OID_EC_PUBLIC_KEY) || std::memcmp(algOid.value, OID_EC_PUBLIC_KEY, algOid.length) != 0) {
+            throw std::invalid_argument("not an EC key");
+        }
+        if (curveOid.length != sizeof(OID_PRIME256V1) || std::memcmp(curveOid.value, OID_PRIME256V1, curveOid.length) != 0) {
+            throw std::invalid_argument("EC curve is not P-256");
+        }
+
+        DERView inner = top.child(2).child(0);
+        this->_readECPrivateKey(inner.value - (inner.totalLength - inner.length), inner.totalLength);
+    }
+    catch (std::invalid_argument& e) {
+        throw std::invalid_argument(std::string("malformed P-256 private key: ") + e.what());
+    }
+}
+
+void ECKey::_readECPrivateKey(const unsigned char* der, size_t len) {
+    DERView seq(der, len);
+    DERView version = seq.child(0);
+    DERView priv = seq.child(1);
+
+    if (version.tag != 0x02 || version.length != 1 || version.value[0] != 1) throw std::invalid_argument("bad ECPrivateKey version");
+    if (priv.tag != 0x04 || priv.length == 0 || priv.length > 32) throw std::invalid_argument("bad private scalar");
+
+    std::memset(this->d, 0, 32);
+    std::memcpy(this->d + 32 - priv.length, priv.value, priv.length);
+
+    for (int i = 2; i < seq.children(); i++) {
+        DERView opt = seq.child(i);
+
+        if (opt.tag == 0xa0) {
+            DERView curveOid = opt.child(0);
+            if (curveOid.length != sizeof(OID_PRIME256V1) || std::memcmp(curveOid.value, OID_PRIME256V1, curveOid.length) != 0) {
+                throw std::invalid_argument("EC curve is not P-256");
+            }
+        }
+        else if (opt.tag == 0xa1) {
+            DERView bits = opt.child(0);
+            if (bits.tag == 0x03 && bits.length == 66 && bits.value[1] == 0x04) {
+                std::memcpy(this->publicKey, bits.value + 1, 65);
+                this->hasPublicKey = true;
+            }
+        }
+    }
+
+    P256::Int k;
+    P256::fromBytes(k, this->d);
+    if (P256::isZero(k) || P256::compare(k, P256::orderModulus().m) >= 0) throw std::invalid_argument("private scalar out of range");
+}
+
+void ECKey::derivePublicKey(unsigned char out[65]) {
+    P256::Int k, x, y;
+    P256::JacobianPoint j;
+    P256::AffinePoint a;
+
+    P256::fromBytes(k, this->d);
+    P256::mulBase(j, k);
+    P256::toAffine(a, j);
+    P256::fromMont(x, a.x, P256::fieldModulus());
+    P256::fromMont(y, a.y, P256::fieldModulus());
+
+    out[0] = 0x04;
+    P256::toBytes(out + 1, x);
+    P256::toBytes(out + 33, y);
+}
+
+void ECKey::sign(const unsigned char hash[32], unsigned char signature[64]) {
+    const P256::Modulus& N = P256::orderModulus();
+    const P256::Modulus& F = P256::fieldModulus();
+    P256::Int e, dM, kM, kinv, r, rM, s, t;
+
+    // e = bits2int(hash) mod n; h1 = bits2octets(hash)
+    P256::fromBytes(e, hash);
+    P256::modSub(e, e, N.m, N);     // e < 2^256 < 2n, one conditional subtraction reduces it
+    unsigned char h1[32];
+    P256::toBytes(h1, e);
+
+    P256::fromBytes(dM, this->d);
+    P256::toMont(dM, dM, N);
+
+    // RFC 6979 section 3.2 with HMAC-SHA256
+    unsigned char K[32], V[32], msg[32 + 1 + 32 + 32];
+    std::memset(K, 0x00, 32);
+    std::memset(V, 0x01, 32);
+
+    for (int round = 0; round < 2; round++) {
+        std::memcpy(msg, V, 32);
+        msg[32] = (unsigned char)round;
+        std::memcpy(msg + 33, this->d, 32);
+        std::memcpy(msg + 65, h1, 32);
+        HMACSHA256(K, 32).sign(msg, sizeof(msg), K);
+        HMACSHA256(K, 32).sign(V, 32, V);
+    }
+
+    while (true) {
+        HMACSHA256(K, 32).sign(V, 32, V);
+
+        P256::Int k;
+        P256::fromBytes(k, V);
+
+        if (!P256::isZero(k) && P256::compare(k, N.m) < 0) {
+            P256::JacobianPoint R;
+            P256::AffinePoint Ra;
+            P256::mulBase(R, k);
+            P256::toAffine(Ra, R);
+
+            // r = x(R) mod n
+            P256::fromMont(r, Ra.x, F);
+            P256::modSub(r, r, N.m, N);
+
+            // s = k^-1 (e + r d) mod n
+            P256::toMont(kM, k, N);
+            P256::modInv(kinv, kM, N);
+            P256::toMont(rM, r, N);
+            P256::montMul(t, rM, dM, N);
+            P256::toMont(s, e, N);
+            P256::modAdd(t, t, s, N);
+            P256::montMul(s, kinv, t, N);
+            P256::fromMont(s, s, N);
+
+            if (!P256::isZero(r) && !P256::isZero(s)) {
+                P256::toBytes(signature, r);
+                P256::toBytes(signature + 32, s);
+                break;
+            }
+        }
+
+        std::memcpy(msg, V, 32);
+        msg[32] = 0x00;
+        HMACSHA256(K, 32).sign(msg, 33, K);
+        HMACSHA256(K, 32).sign(V, 32, V);
+    }
+
+    std::memset(K, 0, 32);
+    std::memset(V, 0, 32);
+    std::memset(msg, 0, sizeof(msg));
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#ifndef P256_H
+#define P256_H
+
+// NIST P-256 arithmetic for ES256. Field and scalar elements are 8 x 32-bit
+// little-endian limbs kept in Montgomery form; every operation on secret data
+// runs in constant time (no secret-dependent branches or table indexes).
+class P256
+{
+public:
+    typedef uint32_t Int[8];
+
+    struct Modulus {
+        Int m;
+        uint32_t m0inv;     // -m^-1 mod 2^32
+        Int rr;             // R^2 mod m
+        Int one;            // R mod m
+    };
+
+    struct AffinePoint { Int x; Int y; };
+    struct JacobianPoint { Int X; Int Y; Int Z; };
+
+    static const int COMB_TEETH = 6;
+    static const int COMB_SPACING = 43;    // COMB_TEETH * COMB_SPACING >= 256
+
+    static const Modulus& fieldModulus();
+    static const Modulus& orderModulus();
+
+    // Montgomery constants for any odd modulus below 2^256 (also used for the Ed25519 group order)
+    static void initModulus(Modulus& M, const Int m);
+
+    // k*G through the fixed-base comb table; k is a plain 256-bit scalar
+    static void mulBase(JacobianPoint& r, const Int k);
+    static void toAffine(AffinePoint& r, const JacobianPoint& p);
+
+    static void fromBytes(Int r, const unsigned char bytes[32]);
+    static void toBytes(unsigned char bytes[32], const Int a);
+
+    static void montMul(Int r, const Int a, const Int b, const Modulus& M);
+    static void modAdd(Int r, const Int a, const Int b, const Modulus& M);
+    static void modSub(Int r, const Int a, const Int b, const Modulus& M);
+    static void toMont(Int r, const Int a, const Modulus& M);
+    static void fromMont(Int r, const Int a, const Modulus& M);
+    static void modInv(Int r, const Int a, const Modulus& M);
+    static uint32_t isZero(const Int a);
+    static int compare(const Int a, const Int b);
+
+private:
+    static void _init();
+    static void _double(JacobianPoint& r, const JacobianPoint& p);
+    static void _addAffine(JacobianPoint& r, const JacobianPoint& p, const AffinePoint& q, uint32_t qIsInfinity);
+    static void _lookup(AffinePoint& r, uint32_t idx);
+};
+
+// EC P-256 private key from SEC1 ("EC PRIVATE KEY") or PKCS#8 ("PRIVATE KEY")
+class ECKey
+{
+public:
+    unsigned char d[32];            // private scalar, big-endian
+    unsigned char publicKey[65];    // uncompressed 04 || X || Y, if present in the key file
+    bool hasPublicKey = false;
+
+    ECKey(std::string& prvKeyPEM);
+    ECKey(const unsigned char* der, size_t len);
+    ~ECKey();
+
+    void derivePublicKey(unsigned char out[65]);
+
+    // ECDSA over a SHA-256 hash with RFC 6979 nonces, signature as raw r || s
+    void sign(const unsigned char hash[32], unsigned char signature[64]);
+
+private:
+    void _readDER(const unsigned char* der, size_t len);
+    void _readECPrivateKey(const unsigned char* der, size_t len);
+};
+
+#endif
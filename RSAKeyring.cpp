@@ -0,0 +1,230 @@
+#include "RSAKeyring.h"
+#include "RSAKeystore.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+// The same key material, so the prepared key already in the table can stay
+static bool _sameKey(RSAKey& a, RSAKey& b) {
+    return a.e == b.e && a.n->compareTo(*b.n) == 0 && a.d->compareTo(*b.d) == 0;
+}
+
+static std::string _jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        }
+        else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else out += (char)c;
+    }
+    return out + "\"";
+}
+
+RSAKeyring::RSAKeyring() : table(std::make_shared<const Table>()) {}
+
+RSAKeyring::~RSAKeyring() {
+    this->unwatch();
+}
+
+std::shared_ptr<const RSAKeyring::Table> RSAKeyring::_current() const {
+    return std::atomic_load(&this->table);
+}
+
+std::shared_ptr<RSAKey> RSAKeyring::find(const std::string& kid) const {
+    std::shared_ptr<const Table> current = this->_current();
+    Table::const_iterator it = current->find(kid);
+
+    return it == current->end() ? std::shared_ptr<RSAKey>() : it->second->key;
+}
+
+std::string RSAKeyring::createJWT(const std::string& kid, const std::string& payload) const {
+    std::shared_ptr<const Table> current = this->_current();
+    Table::const_iterator it = current->find(kid);
+    if (it == current->end()) throw std::invalid_argument("unknown kid " + kid);
+
+    return RSALite::createJWT(it->second->header, payload, *it->second->key);
+}
+
+void RSAKeyring::add(const std::string& kid, RSAKey* key) {
+    std::vector<std::shared_ptr<RSAKey> > keys(1, std::shared_ptr<RSAKey>(key));
+    _prepareAll(keys, 1);
+
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    this->_publish(kid, keys[0]);
+}
+
+void RSAKeyring::add(const std::string& kid, std::string& prvKeyPEM) {
+    this->add(kid, new RSAKey(prvKeyPEM));
+}
+
+bool RSAKeyring::retire(const std::string& kid) {
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    std::shared_ptr<const Table> current = this->_current();
+    if (current->find(kid) == current->end()) return false;
+
+    std::shared_ptr<Table> next = std::make_shared<Table>(*current);
+    next->erase(kid);
+    std::atomic_store(&this->table, std::shared_ptr<const Table>(next));
+
+    return true;
+}
+
+size_t RSAKeyring::load(const std::string& path, unsigned threads) {
+    std::lock_guard<std::mutex> guard(this->writeLock);
+
+    try {
+        RSAKeystore store;
+        std::vector<std::string> files;
+        if (MappedFile::listDirectory(path, files)) store.loadDirectory(path, threads);
+        else store.loadBundle(path, threads);
+
+        // a half-written file must not retire the keys in use
+        if (!store.errors.empty()) throw std::invalid_argument("can't load " + path + ": " + store.errors[0]);
+        if (store.size() == 0) throw std::invalid_argument("no keys in " + path);
+
+        std::shared_ptr<const Table> current = this->_current();
+        std::shared_ptr<Table> next = std::make_shared<Table>();
+        std::vector<std::shared_ptr<RSAKey> > fresh;
+
+        for (size_t i = 0; i < store.size(); i++) {
+            const std::string& kid = store.nameAt(i);
+            std::shared_ptr<RSAKey> key(store.release(i));
+            Table::const_iterator it = current->find(kid);
+
+            if (it != current->end() && _sameKey(*it->second->key, *key)) {
+                (*next)[kid] = it->second;
+                continue;
+            }
+
+            fresh.push_back(key);
+            (*next)[kid] = _entry(kid, key);
+        }
+
+        _prepareAll(fresh, threads);
+        std::atomic_store(&this->table, std::shared_ptr<const Table>(next));
+        this->reloaded++;
+
+        return next->size();
+    }
+    catch (std::exception& e) {
+        this->error = e.what();
+        this->failed++;
+        throw;
+    }
+}
+
+void RSAKeyring::watch(const std::string& path, std::chrono::milliseconds interval) {
+    this->unwatch();
+
+    std::string fingerprint = RSAKeystore::fingerprint(path);
+    this->load(path);
+
+    this->watcher = std::thread(&RSAKeyring::_watch, this, path, interval, fingerprint);
+}
+
+void RSAKeyring::unwatch() {
+    if (!this->watcher.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> guard(this->watchLock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->watcher.join();
+    this->stopping = false;
+}
+
+size_t RSAKeyring::size() const {
+    return this->_current()->size();
+}
+
+std::vector<std::string> RSAKeyring::kids() const {
+    std::shared_ptr<const Table> current = this->_current();
+    std::vector<std::string> kids;
+
+    for (Table::const_iterator it = current->begin(); it != current->end(); ++it) kids.push_back(it->first);
+    std::sort(kids.begin(), kids.end());
+
+    return kids;
+}
+
+uint64_t RSAKeyring::reloads() const {
+    return this->reloaded.load();
+}
+
+uint64_t RSAKeyring::failures() const {
+    return this->failed.load();
+}
+
+std::string RSAKeyring::lastError() {
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    return this->error;
+}
+
+// writeLock held
+void RSAKeyring::_publish(const std::string& kid, std::shared_ptr<RSAKey> key) {
+    std::shared_ptr<Table> next = std::make_shared<Table>(*this->_current());
+    (*next)[kid] = _entry(kid, key);
+    std::atomic_store(&this->table, std::shared_ptr<const Table>(next));
+}
+
+// Polls the content rather than timestamps, so two writes within the
+// filesystem's time resolution are both seen and a touch alone reloads nothing
+void RSAKeyring::_watch(std::string path, std::chrono::milliseconds interval, std::string fingerprint) {
+    std::unique_lock<std::mutex> guard(this->watchLock);
+
+    while (!this->stopping) {
+        this->wake.wait_for(guard, interval);
+        if (this->stopping) break;
+
+        guard.unlock();
+        std::string now = RSAKeystore::fingerprint(path);
+        if (now != fingerprint) {
+            fingerprint = now;
+            try {
+                this->load(path);
+            }
+            catch (std::exception&) {
+                // counted by load(); the current keys stay until the content changes again
+            }
+        }
+        guard.lock();
+    }
+}
+
+// Everything a signing thread could otherwise end up waiting for: the
+// precomputation and the first blinding pair
+void RSAKeyring::_prepareAll(std::vector<std::shared_ptr<RSAKey> >& keys, unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > keys.size()) threads = (unsigned)std::max<size_t>(keys.size(), 1);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&keys, &next]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < keys.size()) {
+            keys[i]->_prepareBlinding();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) pool.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
+
+std::shared_ptr<const RSAKeyring::Entry> RSAKeyring::_entry(const std::string& kid, std::shared_ptr<RSAKey> key) {
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->header = "{\"alg\":\"RS256\",\"typ\":\"JWT\",\"kid\":" + _jsonString(kid) + "}";
+
+    return entry;
+}
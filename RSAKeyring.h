@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "RSALite.h"
+
+#ifndef RSAKEYRING_H
+#define RSAKEYRING_H
+
+// kid -> prepared RSAKey for signing with many keys across rotations. The
+// table is an immutable snapshot published with an atomic shared_ptr store,
+// so a lookup is one atomic load and a hash probe, and no writer ever holds
+// up a signing thread. Writers copy the table, prepare the keys they add
+// before it goes live, and swap it in. A replaced or retired key is freed
+// once the last snapshot or handle still using it is gone.
+class RSAKeyring
+{
+public:
+    RSAKeyring();
+    ~RSAKeyring();
+
+    // NULL for an unknown kid; the handle keeps the key alive after it is retired
+    std::shared_ptr<RSAKey> find(const std::string& kid) const;
+    // RS256 with {"alg":"RS256","typ":"JWT","kid":kid}; invalid_argument for an unknown kid
+    std::string createJWT(const std::string& kid, const std::string& payload) const;
+
+    // takes ownership of key; an existing kid is replaced
+    void add(const std::string& kid, RSAKey* key);
+    void add(const std::string& kid, std::string& prvKeyPEM);
+    bool retire(const std::string& kid);
+
+    // Replaces the whole set with the keys of a directory (kid = file name
+    // without extension) or a PEM/DER bundle (kid = name#index). Keys whose
+    // material is unchanged keep their prepared state; kids that are gone are
+    // retired. Any key failing to parse leaves the current set untouched.
+    size_t load(const std::string& path, unsigned threads = 0);
+
+    // load()s path now, then again on a background thread whenever its
+    // content changes, checked every interval. Failed reloads keep the
+    // current keys and are counted in failures()
+    void watch(const std::string& path, std::chrono::milliseconds interval = std::chrono::seconds(1));
+    void unwatch();
+
+    size_t size() const;
+    std::vector<std::string> kids() const;
+    uint64_t reloads() const;
+    uint64_t failures() const;
+    std::string lastError();
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<RSAKey> key;
+        std::string header;     // with this kid, built once
+    };
+    typedef std::unordered_map<std::string, std::shared_ptr<const Entry> > Table;
+
+    std::shared_ptr<const Table> table;
+    std::mutex writeLock;           // one writer at a time; readers never take it
+    std::string error;              // guarded by writeLock
+
+    std::mutex watchLock;
+    std::condition_variable wake;
+    std::thread watcher;
+    bool stopping = false;
+    std::atomic<uint64_t> reloaded{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+
+    std::shared_ptr<const Table> _current() const;
+    void _publish(const std::string& kid, std::shared_ptr<RSAKey> key);
+    void _watch(std::string path, std::chrono::milliseconds interval, std::string fingerprint);
+    static void _prepareAll(std::vector<std::shared_ptr<RSAKey> >& keys, unsigned threads);
+    static std::shared_ptr<const Entry> _entry(const std::string& kid, std::shared_ptr<RSAKey> key);
+
+    RSAKeyring(const RSAKeyring&);
+    RSAKeyring& operator=(const RSAKeyring&);
+};
+
+#endif
@@ -0,0 +1,309 @@
+#include "RSAKeystore.h"
+#include "MappedFile.h"
+#include "RSASnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+static double _millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string _stem(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+
+    return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+static const unsigned char* _find(const unsigned char* begin, const unsigned char* end, const char* needle) {
+    size_t len = std::strlen(needle);
+    const unsigned char* it = std::search(begin, end, needle, needle + len);
+
+    return it == end ? NULL : it;
+}
+
+RSAKeystore::RSAKeystore() {}
+
+RSAKeystore::~RSAKeystore() {
+    for (size_t i = 0; i < this->keys.size(); i++) {
+        delete(this->keys[i]);
+    }
+}
+
+// One key per file; each worker maps, decodes and parses its own files
+size_t RSAKeystore::loadDirectory(const std::string& path, unsigned threads) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::string> files;
+
+    if (!MappedFile::listDirectory(path, files)) {
+        throw std::invalid_argument("can't read key directory " + path);
+    }
+
+    std::vector<Source> sources(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        sources[i].name = _stem(files[i]);
+        sources[i].path = files[i];
+        sources[i].begin = NULL;
+        sources[i].len = 0;
+        sources[i].pem = true;
+        sources[i].key = NULL;
+    }
+
+    this->stats = RSAKeystoreStats();
+    this->errors.clear();
+    this->stats.mapMillis = _millisSince(start);
+    this->_parseAll(sources, threads);
+    this->stats.totalMillis = _millisSince(start);
+
+    return this->stats.keys;
+}
+
+// Concatenated PEM blocks or concatenated DER PrivateKeyInfo structures
+size_t RSAKeystore::loadBundle(const std::string& path, unsigned threads) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    MappedFile bundle;
+
+    if (!bundle.open(path)) {
+        throw std::invalid_argument("can't open key bundle " + path);
+    }
+
+    std::vector<Source> sources;
+    _splitBundle(bundle.data, bundle.size, _stem(path), sources);
+
+    this->stats = RSAKeystoreStats();
+    this->errors.clear();
+    this->stats.mapMillis = _millisSince(start);
+    this->_parseAll(sources, threads);
+    this->stats.totalMillis = _millisSince(start);
+
+    return this->stats.keys;
+}
+
+// Restores prepared keys from a snapshot. If the image is missing, fails
+// validation or was taken from other contents of the source directory/bundle,
+// the source is reparsed and a fresh snapshot is written in its place. A
+// source that can't be read at all leaves the snapshot to stand on its own.
+size_t RSAKeystore::loadSnapshot(const std::string& path, const std::string& source, unsigned threads) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string error;
+    std::vector<std::string> newNames;
+    std::vector<RSAKey*> newKeys;
+    std::string sourceFingerprint = source.empty() ? "" : fingerprint(source);
+    bool ok;
+
+    {
+        MappedFile image;
+        ok = image.open(path);
+        if (!ok) error = "can't open snapshot " + path;
+        else ok = RSASnapshot::read(image.data, image.size, newNames, newKeys, error, sourceFingerprint);
+    }
+
+    if (ok) {
+        this->stats = RSAKeystoreStats();
+        this->errors.clear();
+        for (size_t i = 0; i < newKeys.size(); i++) this->_add(newNames[i], newKeys[i]);
+        this->stats.sources = 1;
+        this->stats.keys = newKeys.size();
+        this->stats.fromSnapshot = true;
+        this->stats.totalMillis = this->stats.mapMillis = _millisSince(start);
+
+        return this->stats.keys;
+    }
+
+    if (source.empty()) throw std::invalid_argument(error);
+
+    std::vector<std::string> files;
+    size_t loaded = MappedFile::listDirectory(source, files) ? this->loadDirectory(source, threads) : this->loadBundle(source, threads);
+
+    this->stats.snapshotError = error;
+    try {
+        // the fingerprint from before the reparse: a change made meanwhile makes the next start reparse again
+        RSASnapshot::write(path, this->names, this->keys, sourceFingerprint, threads);
+    }
+    catch (std::exception&) {
+        // the keys are loaded, a stale image just means another reparse next start
+    }
+    this->stats.totalMillis = _millisSince(start);
+
+    return loaded;
+}
+
+void RSAKeystore::saveSnapshot(const std::string& path, const std::string& source, unsigned threads) {
+    RSASnapshot::write(path, this->names, this->keys, source.empty() ? "" : fingerprint(source), threads);
+}
+
+size_t RSAKeystore::size() {
+    return this->keys.size();
+}
+
+RSAKey* RSAKeystore::get(const std::string& name) {
+    std::map<std::string, size_t>::iterator it = this->index.find(name);
+
+    return it == this->index.end() ? NULL : this->keys[it->second];
+}
+
+RSAKey* RSAKeystore::at(size_t i) {
+    return this->keys.at(i);
+}
+
+const std::string& RSAKeystore::nameAt(size_t i) {
+    return this->names.at(i);
+}
+
+RSAKey* RSAKeystore::release(size_t i) {
+    RSAKey* key = this->keys.at(i);
+    this->keys[i] = NULL;
+
+    return key;
+}
+
+RSAKeystoreStats& RSAKeystore::lastLoad() {
+    return this->stats;
+}
+
+std::string RSAKeystore::fingerprint(const std::string& source) {
+    std::vector<std::string> files;
+    bool directory = MappedFile::listDirectory(source, files);
+    if (!directory) files.push_back(source);
+
+    SHA256 sha;
+    for (size_t i = 0; i < files.size(); i++) {
+        MappedFile file;
+        if (!file.open(files[i])) return "";
+
+        if (directory) {
+            std::string name = files[i].substr(files[i].find_last_of("/\\") + 1);
+            sha.update(name.c_str(), name.size() + 1);
+        }
+        sha.update(file.data, file.size);
+    }
+
+    unsigned char hash[32];
+    sha.final(hash);
+    return std::string((const char*)hash, 32);
+}
+
+void RSAKeystore::_add(const std::string& name, RSAKey* key) {
+    std::map<std::string, size_t>::iterator it = this->index.find(name);
+
+    if (it != this->index.end()) {
+        delete(this->keys[it->second]);
+        this->keys[it->second] = key;
+    }
+    else {
+        this->index[name] = this->keys.size();
+        this->names.push_back(name);
+        this->keys.push_back(key);
+    }
+}
+
+void RSAKeystore::_parseAll(std::vector<Source>& sources, unsigned threads) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > sources.size()) threads = (unsigned)std::max<size_t>(sources.size(), 1);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&sources, &next]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < sources.size()) {
+            RSAKeystore::_parse(sources[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) pool.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+
+    this->stats.sources = sources.size();
+    this->stats.threads = threads;
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].key == NULL) {
+            this->errors.push_back(sources[i].name + ": " + sources[i].error);
+            this->stats.failures++;
+            continue;
+        }
+
+        this->_add(sources[i].name, sources[i].key);
+        this->stats.keys++;
+    }
+
+    this->stats.parseMillis = _millisSince(start);
+}
+
+void RSAKeystore::_parse(Source& src) {
+    RSALiteStageClock clock;
+
+    try {
+        MappedFile file;
+        const unsigned char* begin = src.begin;
+        size_t len = src.len;
+        bool pem = src.pem;
+
+        if (!src.path.empty()) {
+            if (!file.open(src.path)) throw std::invalid_argument("can't open key file");
+            begin = file.data;
+            len = file.size;
+            pem = len == 0 || begin[0] != 0x30;
+        }
+
+        if (pem) {
+            std::vector<unsigned char> der;
+            RSAKey::pemToDER((const char*)begin, len, der);
+            src.key = new RSAKey(der.data(), der.size());
+        }
+        else {
+            src.key = new RSAKey(begin, len);
+        }
+        clock.lap(STAGE_PARSE);
+        clock.finish(false);
+    }
+    catch (std::exception& e) {
+        src.error = e.what();
+    }
+}
+
+void RSAKeystore::_splitBundle(const unsigned char* data, size_t len, const std::string& prefix, std::vector<Source>& sources) {
+    const unsigned char* end = data + len;
+    const unsigned char* it = data;
+
+    while (it < end) {
+        Source src;
+        src.name = prefix + "#" + std::to_string(sources.size());
+        src.key = NULL;
+
+        if (it[0] == 0x30) {
+            DERView v(it, end - it);
+            src.begin = it;
+            src.len = v.totalLength;
+            src.pem = false;
+            it += v.totalLength;
+        }
+        else {
+            const unsigned char* begin = _find(it, end, "-----BEGIN ");
+            if (begin == NULL) break;
+
+            const unsigned char* footer = _find(begin, end, "-----END ");
+            if (footer == NULL) throw std::invalid_argument("can't find PEM footer in key bundle");
+
+            const unsigned char* last = _find(footer + 9, end, "-----");
+            it = (last == NULL) ? end : last + 5;
+
+            src.begin = begin;
+            src.len = it - begin;
+            src.pem = true;
+        }
+
+        sources.push_back(src);
+
+        while (it < end && (*it == '\n' || *it == '\r' || *it == ' ' || *it == '\t')) it++;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include "RSALite.h"
+
+#ifndef RSAKEYSTORE_H
+#define RSAKEYSTORE_H
+
+struct RSAKeystoreStats
+{
+    size_t sources = 0;         // files (directory) or PEM/DER blocks (bundle)
+    size_t keys = 0;
+    size_t failures = 0;
+    unsigned threads = 0;
+    double mapMillis = 0;       // listing, mapping and splitting the input
+    double parseMillis = 0;     // parallel PKCS#8 parsing
+    double totalMillis = 0;
+    bool fromSnapshot = false;
+    std::string snapshotError;  // why the snapshot was rejected, if it was
+};
+
+// Bulk loader for many PKCS#8 RSA private keys. Files are mapped instead of
+// copied, keys are parsed in parallel straight from DER views and the
+// per-key signing precomputation is deferred to the first createJWT.
+class RSAKeystore
+{
+public:
+    RSAKeystore();
+    ~RSAKeystore();
+
+    size_t loadDirectory(const std::string& path, unsigned threads = 0);
+    size_t loadBundle(const std::string& path, unsigned threads = 0);
+    size_t loadSnapshot(const std::string& path, const std::string& source = "", unsigned threads = 0);
+    // source, when given, is where the keys were loaded from; loadSnapshot
+    // with that source only accepts the image while the source is unchanged
+    void saveSnapshot(const std::string& path, const std::string& source = "", unsigned threads = 0);
+
+    size_t size();
+    RSAKey* get(const std::string& name);
+    RSAKey* at(size_t i);
+    const std::string& nameAt(size_t i);
+    // hands key i over to the caller; get() and at() return NULL for it afterwards
+    RSAKey* release(size_t i);
+
+    RSAKeystoreStats& lastLoad();
+
+    // SHA-256 over a bundle, or over the name and content of every file in a
+    // directory, names taken relative to it so any spelling of the path
+    // agrees; empty when it can't be read
+    static std::string fingerprint(const std::string& source);
+    std::vector<std::string> errors;
+
+private:
+    struct Source {
+        std::string name;
+        std::string path;                 // set when the source is a whole file
+        const unsigned char* begin;
+        size_t len;
+        bool pem;
+        RSAKey* key;
+        std::string error;
+    };
+
+    std::vector<std::string> names;
+    std::vector<RSAKey*> keys;
+    std::map<std::string, size_t> index;
+    RSAKeystoreStats stats;
+
+    void _add(const std::string& name, RSAKey* key);
+    void _parseAll(std::vector<Source>& sources, unsigned threads);
+    static void _parse(Source& src);
+    static void _splitBundle(const unsigned char* data, size_t len, const std::string& prefix, std::vector<Source>& sources);
+
+    RSAKeystore(const RSAKeystore&);
+    RSAKeystore& operator=(const RSAKeystore&);
+};
+
+#endif
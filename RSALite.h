@@ -4,16 +4,88 @@
 #include <map>
 #include <iostream>
 #include <regex>
+#include <mutex>
+#include "RSALiteStats.h"
+#include "RSALiteCounters.h"
+#include "RSALiteArena.h"
+
+#if defined(__has_include)
+#if __has_include(<string_view>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#include <string_view>
+#define RSALITE_HAS_STRING_VIEW 1
+#endif
+#endif
 
 #ifndef RSALITE_H
 #define RSALITE_H
 
+class RSAKey;
+class ECKey;
+class HMACSHA256;
+class Ed25519Key;
+class ClaimsBuilder;
+class RSAPublicKey;
+class SHA256;
+
 class RSALite
 {
 public:
+	enum Algorithm { RS256, ES256, HS256, EdDSA };
+
 	static std::string createJWT(std::string header, std::string payload, std::string privateKey);
+	static std::string createJWT(const std::string& header, const std::string& payload, std::string privateKey, Algorithm alg);
+	static std::string createJWT(const std::string& header, const std::string& payload, RSAKey& rsaKey);
+	static std::string createJWT(const std::string& header, const std::string& payload, ECKey& ecKey);
+	static std::string createJWT(const std::string& header, const std::string& payload, const HMACSHA256& hmacKey);
+	static std::string createJWT(const std::string& header, const std::string& payload, Ed25519Key& edKey);
+	static std::string createJWT(const std::string& header, ClaimsBuilder& claims, RSAKey& rsaKey);
+	static std::string createJWT(const std::string& header, ClaimsBuilder& claims, ECKey& ecKey);
+	static std::string createJWT(const std::string& header, ClaimsBuilder& claims, const HMACSHA256& hmacKey);
+	static std::string createJWT(const std::string& header, ClaimsBuilder& claims, Ed25519Key& edKey);
+
+#ifdef RSALITE_HAS_STRING_VIEW
+	// Writes the JWT into out without touching the heap (RS256: fixed-width
+	// key sizes, others in the RSALITE_FIXED_LIMBS profile) and returns its
+	// length. Nothing is written when that length exceeds capacity, so out may
+	// be NULL to ask for the size. No terminating NUL.
+	static size_t createJWT(std::string_view header, std::string_view payload, RSAKey& rsaKey, char* out, size_t capacity);
+	static size_t createJWT(std::string_view header, std::string_view payload, ECKey& ecKey, char* out, size_t capacity);
+	static size_t createJWT(std::string_view header, std::string_view payload, const HMACSHA256& hmacKey, char* out, size_t capacity);
+	static size_t createJWT(std::string_view header, std::string_view payload, Ed25519Key& edKey, char* out, size_t capacity);
+#endif
+
+	// Detached RS256 (RFC 7797) over a file or stream of any size, hashed a
+	// chunk at a time and never held whole. header must carry "b64":false and
+	// "crit":["b64"]; returns base64url(header) ".." base64url(signature)
+	static std::string createDetachedJWS(const std::string& header, const std::string& path, RSAKey& rsaKey);
+	static std::string createDetachedJWS(const std::string& header, std::istream& content, RSAKey& rsaKey);
+	// bare RSASSA-PKCS1-v1_5 SHA-256 signature of the content, signatureLength() bytes
+	static std::string signFile(const std::string& path, RSAKey& rsaKey);
+	static std::string signStream(std::istream& content, RSAKey& rsaKey);
+
+	// RS256 only, whatever the header says; false for anything malformed
+	static bool verifyJWT(const std::string& jwt, RSAPublicKey& key);
+	// valid[i] is set to 1 for each good jwts[i]; spread over `threads`
+	// threads, 0 for one per core. Returns how many verified
+	static size_t verifyJWTs(const std::vector<std::string>& jwts, RSAPublicKey& key, std::vector<char>& valid, int threads = 0);
+
+	// per-stage latency histograms, empty unless built with RSALITE_STATS
+	static RSALiteStats stats();
+	static std::string statsPrometheus();
+	static void resetStats();
+
+	// this thread's operation counters, all zero unless built with RSALITE_COUNTERS
+	static RSALiteCounters counters();
+	static void resetCounters();
+
+private:
+	static std::string _detachedJWS(const std::string& header, SHA256& sha, RSAKey& rsaKey, RSALiteStageClock& clock);
 };
 
+class Montgomery;
+class ExpSchedule;
+class RSAFixedSigner;
+
 
 class BigInteger
 {
@@ -29,7 +101,21 @@ public:
     static BigInteger* nbi();
     static BigInteger* nbv(int i);
 
-    std::vector<unsigned int> data;
+#if defined(RSALITE_FIXED_LIMBS)
+#ifndef RSALITE_MAX_KEY_BITS
+#define RSALITE_MAX_KEY_BITS 4096
+#endif
+    // a double-width product of the largest modulus plus the word of slack
+    // division and Montgomery reduction write past it (26-bit limbs)
+    static const int MAX_LIMBS = 2 * ((RSALITE_MAX_KEY_BITS + 25) / 26) + 4;
+    typedef RSALiteFixedVector<unsigned int, MAX_LIMBS> Limbs;
+#elif defined(RSALITE_COUNTERS)
+    typedef std::vector<unsigned int, RSALiteCountingAllocator<unsigned int> > Limbs;
+#else
+    typedef std::vector<unsigned int> Limbs;
+#endif
+
+    Limbs data;
     int t = 0;
     int s = 0;
 
@@ -37,7 +123,15 @@ public:
     BigInteger(const std::string& a);
     ~BigInteger();
 
+#ifdef RSALITE_FIXED_LIMBS
+    // from the thread's RSALiteArena inside an RSALiteArenaScope, else the heap
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+#endif
+
     void fromString(const std::string& s);
+    void fromBytes(const unsigned char* bytes, size_t len);
+    void toBytes(unsigned char* bytes, size_t len);
     void clamp();
     void fromInt(int x);
     int bitLength();
@@ -55,21 +149,92 @@ public:
     void squareTo(BigInteger& r);
     void multiplyTo(BigInteger& a, BigInteger& r);
     BigInteger* modPow(BigInteger& e, BigInteger& m);
+    BigInteger* modPow(ExpSchedule& e, Montgomery& z);
     BigInteger* add(BigInteger& a);
     void addTo(BigInteger& a, BigInteger& r);
     BigInteger* subtract(BigInteger& a);
     BigInteger* multiply(BigInteger& a);
+    BigInteger* modInverse(BigInteger& m);
     std::string toString();
     void print();
     unsigned int intValue();
 
 private:
-    std::map<int, int> BI_RC;
     const std::string BI_RM;
 
-    void _init();
     int _intAt(const std::string& s, int i);
     int _nbits(unsigned int x);
+
+    friend class ExpSchedule;
+};
+
+// Precomputed sliding-window decomposition of a fixed exponent
+class ExpSchedule
+{
+public:
+    static const int MAX_WINDOW = 6;
+
+    int k = 0;
+    std::vector<int> steps;    // (squarings, window) pairs, window 0 = square only
+
+    ExpSchedule();
+    ExpSchedule(BigInteger& e);
+};
+
+// Incremental SHA-256; H holds the chaining state between blocks
+class SHA256 {
+public:
+    static const unsigned int K[64];
+
+    unsigned int H[8];
+    unsigned char buffer[64];
+    size_t bufferLen;
+    unsigned long long totalLen;
+
+    SHA256();
+
+    void reset();
+    void resume(const unsigned int state[8], unsigned long long absorbed);
+    void update(const void* data, size_t len);
+    void final(unsigned char digest[32]);
+
+    static void compress(unsigned int H[8], const unsigned char* block);
+};
+
+// Incremental SHA-512 for Ed25519; same shape as SHA256 with 128-byte blocks
+class SHA512 {
+public:
+    static const unsigned long long K[80];
+
+    unsigned long long H[8];
+    unsigned char buffer[128];
+    size_t bufferLen;
+    unsigned long long totalLen;
+
+    SHA512();
+
+    void reset();
+    void update(const void* data, size_t len);
+    void final(unsigned char digest[64]);
+
+    static void compress(unsigned long long H[8], const unsigned char* block);
+};
+
+// HMAC-SHA256 keyed once: the states after absorbing K^ipad and K^opad are
+// kept, so a MAC costs the message blocks plus one outer block
+class HMACSHA256 {
+public:
+    HMACSHA256(const void* key, size_t len);
+    HMACSHA256(const std::string& key);
+    ~HMACSHA256();
+
+    void sign(const void* data, size_t len, unsigned char mac[32]) const;
+
+private:
+    unsigned int inner[8];
+    unsigned int outer[8];
+
+    void _init(const void* key, size_t len);
 };
 
 class Digest {
@@ -77,22 +242,24 @@ public:
     static std::string digestStringWithSHA256(const std::string& data);
     static std::string getPaddedDigestInfoHex(std::string s, int keySize);
     static std::string urlsafeB64Encode(const std::string& value);
+    // unpadded base64url into out, returns the length; each group is read
+    // before it is written, so data may sit at the tail of out's range
+    static size_t urlsafeB64Encode(const void* data, size_t len, char* out);
+    static size_t urlsafeB64Length(size_t len);
     static char int2char(int n);
     static std::string hex2b64(std::string h);
     static const std::string b64map;
     static const char b64pad;
     static std::string urlsafe(std::string s);
+    static std::string b64encode(const void* data, size_t len);    // standard alphabet, padded
+    static void b64decode(const char* s, size_t len, std::vector<unsigned char>& out);
 
 private:
     static const std::string base64_chars;
     static const std::string BI_RM;
-    static std::vector<unsigned int> _convertStringToWordArray(std::string latin1Str);
-    static std::string _convertWordArrayToString(std::vector<unsigned int> words, int sigBytes);
+    static std::string _convertBytesToString(const unsigned char* bytes, int len);
     static char _intToHex(unsigned int val);
-    static void _process(std::vector<unsigned int>& H, std::vector<unsigned int>& K, std::vector<unsigned int>& W, std::vector<unsigned int>& dataWords, int dataSigBytes);
     static std::string _base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
-    static std::vector<unsigned int> digestDataWords;
-    static int digestDataSigBytes;
 };
 
 class Montgomery
@@ -104,10 +271,13 @@ public:
     int mph;
     int um;
     int mt2;
+    BigInteger* r2 = NULL;
 
     Montgomery(BigInteger* m);
     ~Montgomery();
 
+    void prepareR2();
+
     BigInteger* convert(BigInteger& x);
     BigInteger* revert(BigInteger& x);
     void reduce(BigInteger& x);
@@ -115,37 +285,98 @@ public:
     void mulTo(BigInteger& x, BigInteger& y, BigInteger& r);
 };
 
+// Non-owning view over a single DER TLV
+class DERView
+{
+public:
+    int tag = -1;
+    const unsigned char* value = NULL;
+    size_t length = 0;
+    size_t totalLength = 0;
+
+    DERView();
+    DERView(const unsigned char* der, size_t len);
+
+    DERView child(int nth) const;
+    int children() const;
+};
+
+// A prime beyond p and q of a multi-prime key (RFC 8017 OtherPrimeInfo) and
+// its share of the per-key precomputation
+struct RSAOtherPrime
+{
+    BigInteger* r = NULL;
+    BigInteger* d = NULL;          // d mod (r - 1)
+    BigInteger* t = NULL;          // (p * q * ... * the previous r)^-1 mod r
+    Montgomery* mont = NULL;
+    ExpSchedule* schedule = NULL;
+};
+
 class RSAKey
 {
 public:
-    BigInteger* n;
-    int e;
-    BigInteger* d;
-    BigInteger* p;
-    BigInteger* q;
-    BigInteger* dmp1;
-    BigInteger* dmq1;
-    BigInteger* coeff;
+    BigInteger* n = NULL;
+    int e = 0;
+    BigInteger* d = NULL;
+    BigInteger* p = NULL;
+    BigInteger* q = NULL;
+    BigInteger* dmp1 = NULL;
+    BigInteger* dmq1 = NULL;
+    BigInteger* coeff = NULL;
+    std::vector<RSAOtherPrime> otherPrimes;    // empty for two-prime keys
+
+    // per-key precomputation for the CRT halves, built by prepare()
+    Montgomery* pMont = NULL;
+    Montgomery* qMont = NULL;
+    ExpSchedule* dmp1Schedule = NULL;
+    ExpSchedule* dmq1Schedule = NULL;
+    RSAFixedSigner* fixed = NULL;   // compile-time width CRT path for common key sizes, else NULL
 
     RSAKey(std::string& prvKeyPEM);
+    RSAKey(const unsigned char* der, size_t len);
     ~RSAKey();
 
+    void prepare();
+
+    // RSASSA-PKCS1-v1_5 over a SHA-256 hash; signature receives signatureLength() bytes
+    void sign(const unsigned char hash[32], unsigned char* signature);
+    size_t signatureLength();
+
+    static void pemToDER(const char* pem, size_t len, std::vector<unsigned char>& der);
+
+    // A new key with a bits-long modulus split into 2 to 4 primes. Candidates
+    // are tested on `threads` threads at once, 0 for one per core
+    static RSAKey* generate(int bits, int e = 65537, int primes = 2, int threads = 0);
+
+    // PKCS#8 PrivateKeyInfo, the form the constructors read
+    void toDER(std::vector<unsigned char>& der);
+    std::string toPEM();
+
 private:
-    void _readPKCS8PrvKeyHex(std::string h);
-    std::string _pemtohex(std::string s, std::string sHead);
-    std::string _b64tohex(std::string s);
-    bool _isASN1HEX(std::string hex);
-    int _getVblen(std::string s, int idx);
-    std::string _getL(std::string s, int idx);
-    int _getLblen(std::string s, int idx);
-    std::string _getVbyListEx(std::string h, int currentIndex, std::vector<int>& nthList, std::string checkingTag);
-    int _getIdxbyListEx(std::string h, int currentIndex, std::vector<int>& nthList, std::string checkingTag);
-    std::string _getV(std::string s, int idx);
-    int _getVidx(std::string s, int idx);
-    std::vector<int> _getChildIdx(std::string h, int idx);
-    int _getTLVblen(std::string h, int idx);
-    void _setPrivateEx(std::string N, std::string E, std::string D, std::string P, std::string Q, std::string DP, std::string DQ, std::string C);
-    std::string _getCleanB64(std::string str);
+    std::once_flag prepared;
+
+    // base blinding for the dynamic path: r^e R and r^-1 R mod p, q and the
+    // other primes in turn, squared after each use; the first pair is built
+    // once, by _prepareBlinding()
+    std::once_flag blinded;
+    std::vector<BigInteger*> blinding;
+    std::mutex blindingLock;
+
+    RSAKey();
+
+    void _readPKCS8PrvKeyDER(const unsigned char* der, size_t len);
+    BigInteger* _getInteger(DERView& seq, int nth);
+    void _checkCRT();
+    void _deleteOtherPrimes();
+    void _deletePrecomputation();
+    void _prepareBlinding();
+    void _initBlinding();
+    BigInteger* _blind(size_t i, BigInteger& x, Montgomery& z);
+    void _sign(const unsigned char hash[32], unsigned char* signature, RSALiteStageClock& clock);
+
+    friend class RSALite;
+    friend class RSASnapshot;
+    friend class RSAKeyring;
 };
 
 #endif
\ No newline at end of file
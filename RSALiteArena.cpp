@@ -0,0 +1,108 @@
+#include "RSALiteArena.h"
+#include <cstdint>
+
+static thread_local RSALiteArena* CURRENT_ARENA = NULL;
+
+RSALiteArena::RSALiteArena(void* buffer, size_t size) {
+    this->begin = (unsigned char*)buffer;
+    this->end = this->begin + size;
+    this->top = this->begin;
+}
+
+void* RSALiteArena::allocate(size_t bytes, size_t alignment) {
+    return this->do_allocate(bytes, alignment);
+}
+
+void RSALiteArena::deallocate(void* p, size_t bytes, size_t alignment) {
+    this->do_deallocate(p, bytes, alignment);
+}
+
+bool RSALiteArena::owns(const void* p) const {
+    return (const unsigned char*)p >= this->begin && (const unsigned char*)p < this->end;
+}
+
+RSALiteArena* RSALiteArena::current() {
+    return CURRENT_ARENA;
+}
+
+void* RSALiteArena::do_allocate(size_t bytes, size_t alignment) {
+    size_t size = _round(bytes);
+    bool pooled = alignment <= alignof(std::max_align_t);
+
+    FreeList* list = pooled ? this->_freeList(size, false) : NULL;
+    void* p = NULL;
+
+    if (list != NULL && list->head != NULL) {
+        p = list->head;
+        std::memcpy(&list->head, p, sizeof(void*));
+    }
+    else {
+        uintptr_t at = ((uintptr_t)this->top + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (at + size > (uintptr_t)this->end || at < (uintptr_t)this->top) throw std::bad_alloc();
+
+        p = (void*)at;
+        this->last = (unsigned char*)at;
+        this->top = (unsigned char*)at + size;
+        if ((size_t)(this->top - this->begin) > this->highWater) this->highWater = this->top - this->begin;
+    }
+
+    this->inUse += size;
+
+    return p;
+}
+
+void RSALiteArena::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (p == NULL) return;
+
+    size_t size = _round(bytes);
+    this->inUse -= size;
+
+    if ((unsigned char*)p == this->last && (unsigned char*)p + size == this->top) {
+        this->top = this->last;
+        this->last = NULL;
+        return;
+    }
+
+    // over-aligned blocks are only reclaimed from the top
+    if (alignment > alignof(std::max_align_t)) return;
+
+    FreeList* list = this->_freeList(size, true);
+    if (list == NULL) return;
+
+    std::memcpy(p, &list->head, sizeof(void*));
+    list->head = p;
+}
+
+#ifdef RSALITE_HAS_PMR
+bool RSALiteArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+#endif
+
+size_t RSALiteArena::_round(size_t bytes) {
+    size_t unit = alignof(std::max_align_t);
+    if (bytes < sizeof(void*)) bytes = sizeof(void*);
+    return (bytes + unit - 1) / unit * unit;
+}
+
+// With every size class taken, a freed block of a new size is lost until the arena is rebuilt
+RSALiteArena::FreeList* RSALiteArena::_freeList(size_t size, bool create) {
+    for (int i = 0; i < SIZE_CLASSES; i++) {
+        if (this->free[i].size == size) return &this->free[i];
+        if (this->free[i].size == 0) {
+            if (!create) return NULL;
+            this->free[i].size = size;
+            return &this->free[i];
+        }
+    }
+    return NULL;
+}
+
+RSALiteArenaScope::RSALiteArenaScope(RSALiteArena* arena) {
+    this->previous = CURRENT_ARENA;
+    CURRENT_ARENA = arena;
+}
+
+RSALiteArenaScope::~RSALiteArenaScope() {
+    CURRENT_ARENA = this->previous;
+}
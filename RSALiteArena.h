@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define RSALITE_HAS_PMR 1
+#endif
+#endif
+
+#ifndef RSALITEARENA_H
+#define RSALITEARENA_H
+
+// Inline replacement for std::vector with a compile-time capacity, used for
+// BigInteger limbs in RSALITE_FIXED_LIMBS builds. Growing past N throws
+// std::length_error; newly exposed elements are zeroed like vector::resize.
+template<typename T, size_t N>
+class RSALiteFixedVector
+{
+public:
+    typedef T value_type;
+
+    RSALiteFixedVector() {}
+
+    size_t size() const { return this->count; }
+    size_t capacity() const { return N; }
+    bool empty() const { return this->count == 0; }
+
+    T* data() { return this->items; }
+    const T* data() const { return this->items; }
+
+    T& operator[](size_t i) { return this->items[i]; }
+    const T& operator[](size_t i) const { return this->items[i]; }
+
+    void resize(size_t n) {
+        if (n > N) throw std::length_error("BigInteger exceeds RSALITE_MAX_KEY_BITS");
+        if (n > this->count) std::memset(this->items + this->count, 0, (n - this->count) * sizeof(T));
+        this->count = n;
+    }
+
+    void push_back(const T& v) {
+        if (this->count == N) throw std::length_error("BigInteger exceeds RSALITE_MAX_KEY_BITS");
+        this->items[this->count++] = v;
+    }
+
+    void clear() { this->count = 0; }
+
+private:
+    T items[N];
+    size_t count = 0;
+};
+
+#ifdef RSALITE_HAS_PMR
+#define RSALITE_ARENA_BASE : public std::pmr::memory_resource
+#else
+#define RSALITE_ARENA_BASE
+#endif
+
+// Allocator over a caller-supplied buffer. Freed blocks go on per-size free
+// lists and the most recent block is given back to the bump pointer, which
+// suits the few fixed sizes signing allocates. Exhaustion throws
+// std::bad_alloc; the arena never falls back to the heap. Where the standard
+// library has <memory_resource> this is a std::pmr::memory_resource.
+//
+// An arena is used by one thread at a time: RSALiteArenaScope makes it the
+// calling thread's current arena, and in RSALITE_FIXED_LIMBS builds every
+// BigInteger created inside the scope comes from it. Key material is always
+// kept on the heap, so keys and their precomputation outlive the scope.
+class RSALiteArena RSALITE_ARENA_BASE
+{
+public:
+    RSALiteArena(void* buffer, size_t size);
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    bool owns(const void* p) const;
+
+    size_t capacity() const { return (size_t)(this->end - this->begin); }
+    size_t used() const { return this->inUse; }
+    size_t peak() const { return this->highWater; }     // smallest buffer that would have served every request so far
+    void resetPeak() { this->highWater = (size_t)(this->top - this->begin); }
+
+    static RSALiteArena* current();
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment);
+    void do_deallocate(void* p, size_t bytes, size_t alignment);
+#ifdef RSALITE_HAS_PMR
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept;
+#endif
+
+private:
+    static const int SIZE_CLASSES = 8;
+
+    struct FreeList
+    {
+        size_t size = 0;
+        void* head = NULL;
+    };
+
+    unsigned char* begin;
+    unsigned char* end;
+    unsigned char* top;
+    unsigned char* last = NULL;     // most recent bump allocation, can be popped on free
+    size_t inUse = 0;
+    size_t highWater = 0;
+    FreeList free[SIZE_CLASSES];
+
+    static size_t _round(size_t bytes);
+    FreeList* _freeList(size_t size, bool create);
+};
+
+#undef RSALITE_ARENA_BASE
+
+// Makes arena the calling thread's current arena until the scope ends; NULL
+// suspends an outer scope so long-lived objects go to the heap
+class RSALiteArenaScope
+{
+public:
+    explicit RSALiteArenaScope(RSALiteArena* arena);
+    ~RSALiteArenaScope();
+
+    RSALiteArenaScope(const RSALiteArenaScope&) = delete;
+    RSALiteArenaScope& operator=(const RSALiteArenaScope&) = delete;
+
+private:
+    RSALiteArena* previous;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifndef RSALITECOUNTERS_H
+#define RSALITECOUNTERS_H
+
+// Exact operation and allocation counts for the calling thread. Only updated
+// when built with RSALITE_COUNTERS; otherwise every RSALITE_COUNT is a no-op
+// and the counters stay zero.
+struct RSALiteCounters
+{
+    uint64_t amIterations = 0;      // limb steps through BigInteger::am
+    uint64_t multiplyTo = 0;
+    uint64_t squareTo = 0;
+    uint64_t reduce = 0;            // Montgomery::reduce
+    uint64_t divRemTo = 0;
+    uint64_t bigIntegers = 0;       // BigInteger constructions
+    uint64_t allocations = 0;       // limb buffer allocations
+    uint64_t bytesAllocated = 0;
+    uint64_t digestBlocks = 0;      // SHA-256 / SHA-512 compressions
+
+    static RSALiteCounters& current();
+};
+
+#ifdef RSALITE_COUNTERS
+#define RSALITE_COUNT(field, n) (RSALiteCounters::current().field += (n))
+#else
+#define RSALITE_COUNT(field, n) ((void)0)
+#endif
+
+// std::allocator that also counts into RSALiteCounters; BigInteger limbs use
+// it in RSALITE_COUNTERS builds
+template<typename T>
+struct RSALiteCountingAllocator
+{
+    typedef T value_type;
+
+    RSALiteCountingAllocator() {}
+    template<typename U> RSALiteCountingAllocator(const RSALiteCountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        RSALITE_COUNT(allocations, 1);
+        RSALITE_COUNT(bytesAllocated, n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U> bool operator==(const RSALiteCountingAllocator<U>&) const { return true; }
+    template<typename U> bool operator!=(const RSALiteCountingAllocator<U>&) const { return false; }
+};
+
+#endif
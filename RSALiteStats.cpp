@@ -0,0 +1,232 @@
+#include "RSALiteStats.h"
+#include "RSALite.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+static const char* STAGE_NAMES[STAGE_COUNT] = { "parse", "prepare", "hash", "exp_p", "exp_q", "recombine", "sign", "encode", "total" };
+
+int RSALiteHistogram::bucketIndex(uint64_t nanos) {
+    if (nanos < (uint64_t)SUB_BUCKETS) return (int)nanos;
+
+    int e = 63;
+    while (((nanos >> e) & 1) == 0) e--;
+    if (e > MAX_EXPONENT) return BUCKETS - 1;
+
+    int sub = (int)(nanos >> (e - SUB_BITS)) - SUB_BUCKETS;
+    return SUB_BUCKETS + (e - SUB_BITS) * SUB_BUCKETS + sub;
+}
+
+uint64_t RSALiteHistogram::bucketLower(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+
+    int e = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+    int sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    return (uint64_t)(SUB_BUCKETS + sub) << (e - SUB_BITS);
+}
+
+uint64_t RSALiteHistogram::bucketUpper(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+    if (index == BUCKETS - 1) return UINT64_MAX;
+
+    int e = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+    return bucketLower(index) + ((uint64_t)1 << (e - SUB_BITS)) - 1;
+}
+
+double RSALiteStageStats::meanNanos() const {
+    return this->count == 0 ? 0 : (double)this->sumNanos / this->count;
+}
+
+uint64_t RSALiteStageStats::percentile(double p) const {
+    if (this->count == 0) return 0;
+
+    uint64_t rank = (uint64_t)(p / 100 * this->count + 0.5);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < this->buckets.size(); i++) {
+        seen += this->buckets[i];
+        if (seen >= rank) return std::min(RSALiteHistogram::bucketUpper((int)i), this->maxNanos);
+    }
+    return this->maxNanos;
+}
+
+const RSALiteStageStats& RSALiteStats::stage(RSALiteStage s) const {
+    return this->stages[s];
+}
+
+#ifdef RSALITE_STATS
+
+// One block per thread, linked into a list that only ever grows. Each block
+// has a single writer, so updates are relaxed load/store pairs without locked
+// instructions; readers merge with relaxed loads. A block whose thread exited
+// is adopted by the next new thread and keeps its counts. Blocks are cache
+// line aligned so neighbouring threads never write the same line.
+struct alignas(64) _ThreadStats
+{
+    std::atomic<uint64_t> buckets[STAGE_COUNT][RSALiteHistogram::BUCKETS];
+    std::atomic<uint64_t> sum[STAGE_COUNT];
+    std::atomic<uint64_t> max[STAGE_COUNT];
+    std::atomic<bool> inUse;
+    _ThreadStats* next;
+
+    _ThreadStats() : next(NULL) {
+        this->clear();
+        this->inUse.store(true);
+    }
+
+    void clear() {
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            for (int b = 0; b < RSALiteHistogram::BUCKETS; b++) this->buckets[s][b].store(0, std::memory_order_relaxed);
+            this->sum[s].store(0, std::memory_order_relaxed);
+            this->max[s].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+static std::atomic<_ThreadStats*> STATS_HEAD(NULL);
+
+static _ThreadStats* _acquireBlock() {
+    for (_ThreadStats* it = STATS_HEAD.load(std::memory_order_acquire); it != NULL; it = it->next) {
+        bool expected = false;
+        if (it->inUse.compare_exchange_strong(expected, true)) return it;
+    }
+
+    _ThreadStats* block = new _ThreadStats();
+    _ThreadStats* head = STATS_HEAD.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!STATS_HEAD.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+
+    return block;
+}
+
+struct _ThreadStatsOwner
+{
+    _ThreadStats* block = NULL;
+
+    ~_ThreadStatsOwner() {
+        if (this->block != NULL) this->block->inUse.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local _ThreadStatsOwner STATS_OWNER;
+
+static inline void _bump(std::atomic<uint64_t>& a, uint64_t v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+RSALiteStageClock::RSALiteStageClock() {
+    this->start = this->last = std::chrono::steady_clock::now();
+    for (int i = 0; i < STAGE_COUNT; i++) this->pending[i] = 0;
+}
+
+void RSALiteStageClock::lap(RSALiteStage stage) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    this->pending[stage] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->last).count();
+    this->touched |= 1u << stage;
+    this->last = now;
+}
+
+void RSALiteStageClock::finish(bool recordTotal) {
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if (this->touched & (1u << s)) record((RSALiteStage)s, this->pending[s]);
+    }
+    if (!recordTotal) return;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    record(STAGE_TOTAL, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->start).count());
+}
+
+void RSALiteStageClock::record(RSALiteStage stage, uint64_t nanos) {
+    _ThreadStats* block = STATS_OWNER.block;
+    if (block == NULL) block = STATS_OWNER.block = _acquireBlock();
+
+    _bump(block->buckets[stage][RSALiteHistogram::bucketIndex(nanos)], 1);
+    _bump(block->sum[stage], nanos);
+    if (nanos > block->max[stage].load(std::memory_order_relaxed)) block->max[stage].store(nanos, std::memory_order_relaxed);
+}
+
+// Best effort while other threads are signing: a sample in flight may survive the reset
+void RSALiteStageClock::reset() {
+    for (_ThreadStats* it = STATS_HEAD.load(std::memory_order_acquire); it != NULL; it = it->next) it->clear();
+}
+
+RSALiteStats RSALite::stats() {
+    RSALiteStats snapshot;
+    snapshot.enabled = true;
+
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        snapshot.stages[s].name = STAGE_NAMES[s];
+        snapshot.stages[s].buckets.assign(RSALiteHistogram::BUCKETS, 0);
+    }
+
+    for (_ThreadStats* it = STATS_HEAD.load(std::memory_order_acquire); it != NULL; it = it->next) {
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            RSALiteStageStats& stage = snapshot.stages[s];
+
+            for (int b = 0; b < RSALiteHistogram::BUCKETS; b++) {
+                uint64_t n = it->buckets[s][b].load(std::memory_order_relaxed);
+                stage.buckets[b] += n;
+                stage.count += n;
+            }
+            stage.sumNanos += it->sum[s].load(std::memory_order_relaxed);
+            stage.maxNanos = std::max(stage.maxNanos, it->max[s].load(std::memory_order_relaxed));
+        }
+    }
+
+    return snapshot;
+}
+
+#else
+
+RSALiteStats RSALite::stats() {
+    RSALiteStats snapshot;
+
+    for (int s = 0; s < STAGE_COUNT; s++) snapshot.stages[s].name = STAGE_NAMES[s];
+
+    return snapshot;
+}
+
+#endif
+
+void RSALite::resetStats() {
+    RSALiteStageClock::reset();
+}
+
+// Prometheus text exposition; the HDR buckets are folded into power-of-two
+// boundaries from ~1us to ~69s to keep the series count reasonable
+std::string RSALite::statsPrometheus() {
+    RSALiteStats snapshot = RSALite::stats();
+    std::string out;
+    char line[256];
+
+    if (!snapshot.enabled) return "# rsalite built without RSALITE_STATS\n";
+
+    out += "# HELP rsalite_stage_seconds Time spent in each stage of JWT signing.\n";
+    out += "# TYPE rsalite_stage_seconds histogram\n";
+
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const RSALiteStageStats& stage = snapshot.stages[s];
+        uint64_t cumulative = 0;
+        int b = 0;
+
+        for (int e = 10; e <= 36; e++) {
+            uint64_t bound = (uint64_t)1 << e;
+            while (b < RSALiteHistogram::BUCKETS && RSALiteHistogram::bucketUpper(b) < bound) cumulative += stage.buckets[b++];
+
+            std::snprintf(line, sizeof(line), "rsalite_stage_seconds_bucket{stage=\"%s\",le=\"%.9g\"} %llu\n", stage.name, bound / 1e9, (unsigned long long)cumulative);
+            out += line;
+        }
+
+        std::snprintf(line, sizeof(line), "rsalite_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", stage.name, (unsigned long long)stage.count);
+        out += line;
+        std::snprintf(line, sizeof(line), "rsalite_stage_seconds_sum{stage=\"%s\"} %.9g\n", stage.name, stage.sumNanos / 1e9);
+        out += line;
+        std::snprintf(line, sizeof(line), "rsalite_stage_seconds_count{stage=\"%s\"} %llu\n", stage.name, (unsigned long long)stage.count);
+        out += line;
+    }
+
+    return out;
+}
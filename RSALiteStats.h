@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef RSALITESTATS_H
+#define RSALITESTATS_H
+
+// Signing pipeline stages. PARSE and PREPARE cover key loading and the
+// lazy per-key precomputation; TOTAL is the whole signing call after the key
+// is available.
+enum RSALiteStage
+{
+    STAGE_PARSE,
+    STAGE_PREPARE,
+    STAGE_HASH,
+    STAGE_EXP_P,
+    STAGE_EXP_Q,
+    STAGE_RECOMBINE,
+    STAGE_SIGN,         // ES256 / EdDSA / HS256 private operation
+    STAGE_ENCODE,       // base64url of header, payload and signature
+    STAGE_TOTAL,
+    STAGE_COUNT
+};
+
+// Log-linear (HDR-style) bucketing of nanosecond latencies: exact below 16 ns,
+// then 16 sub-buckets per power of two, so every bucket is within ~6% of
+// its values. Values beyond 2^40 ns land in the last bucket.
+struct RSALiteHistogram
+{
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketIndex(uint64_t nanos);
+    static uint64_t bucketLower(int index);
+    static uint64_t bucketUpper(int index);    // inclusive
+};
+
+struct RSALiteStageStats
+{
+    const char* name = "";
+    uint64_t count = 0;
+    uint64_t sumNanos = 0;
+    uint64_t maxNanos = 0;
+    std::vector<uint64_t> buckets;
+
+    double meanNanos() const;
+    uint64_t percentile(double p) const;     // upper edge of the bucket holding the p-th percentile, p in [0, 100]
+};
+
+// Point-in-time merge of every thread's histograms
+struct RSALiteStats
+{
+    bool enabled = false;
+    RSALiteStageStats stages[STAGE_COUNT];
+
+    const RSALiteStageStats& stage(RSALiteStage s) const;
+};
+
+#ifdef RSALITE_STATS
+
+// Times consecutive stages of one signing call. Laps accumulate per stage and
+// are published once by finish(), so a stage entered twice counts as one sample;
+// key loading in front of a signing call publishes without a TOTAL sample.
+class RSALiteStageClock
+{
+public:
+    RSALiteStageClock();
+
+    void lap(RSALiteStage stage);
+    void finish(bool recordTotal = true);
+
+    static void record(RSALiteStage stage, uint64_t nanos);
+    static void reset();
+
+private:
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+    uint64_t pending[STAGE_COUNT];
+    unsigned touched = 0;
+};
+
+#else
+
+// Stats compiled out: every call is an empty inline and disappears
+class RSALiteStageClock
+{
+public:
+    void lap(RSALiteStage) {}
+    void finish(bool = true) {}
+
+    static void record(RSALiteStage, uint64_t) {}
+    static void reset() {}
+};
+
+#endif
+
+#endif
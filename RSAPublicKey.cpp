@@ -0,0 +1,228 @@
+#include "RSAPublicKey.h"
+#include "FixedBigInt.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+static const unsigned char RSA_ENCRYPTION[9] = { 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01 };
+static const unsigned char SHA256_DIGEST_INFO[19] = {
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+    0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+static const int VERIFY_BATCH = 16;     // tokens a batch worker claims at a time
+
+RSAPublicKey::RSAPublicKey(std::string& pubKeyPEM) {
+    std::vector<unsigned char> der;
+    RSAKey::pemToDER(pubKeyPEM.data(), pubKeyPEM.size(), der);
+    this->_readDER(der.data(), der.size());
+}
+
+RSAPublicKey::RSAPublicKey(const unsigned char* der, size_t len) {
+    this->_readDER(der, len);
+}
+
+RSAPublicKey::RSAPublicKey(RSAKey& key) {
+    RSALiteArenaScope heap(NULL);
+
+    this->n = BigInteger::nbi();
+    key.n->copyTo(*this->n);
+    this->e = key.e;
+}
+
+RSAPublicKey::~RSAPublicKey() {
+    delete(this->n);
+    delete(this->mont);
+    delete(this->schedule);
+    delete(this->fixed);
+}
+
+// SubjectPublicKeyInfo wraps the PKCS#1 RSAPublicKey { n, e } in a BIT STRING
+// after the rsaEncryption AlgorithmIdentifier; a bare RSAPublicKey starts with n
+void RSAPublicKey::_readDER(const unsigned char* der, size_t len) {
+    RSALiteArenaScope heap(NULL);
+
+    try {
+        DERView rsaPubKey(der, len);
+        if (rsaPubKey.tag != 0x30) throw std::invalid_argument("not a DER SEQUENCE");
+
+        if (rsaPubKey.child(0).tag == 0x30) {
+            DERView algorithm = rsaPubKey.child(0).child(0);
+            if (algorithm.tag != 0x06 || algorithm.length != sizeof(RSA_ENCRYPTION) || std::memcmp(algorithm.value, RSA_ENCRYPTION, sizeof(RSA_ENCRYPTION)) != 0)
+                throw std::invalid_argument("not an RSA public key");
+
+            DERView bits = rsaPubKey.child(1);
+            if (bits.tag != 0x03 || bits.length < 1 || bits.value[0] != 0) throw std::invalid_argument("bad subjectPublicKey");
+            rsaPubKey = bits.child(0);
+        }
+
+        DERView vN = rsaPubKey.child(0), vE = rsaPubKey.child(1);
+        if (vN.tag != 0x02 || vE.tag != 0x02 || vE.length == 0 || vE.length > 4) throw std::invalid_argument("bad RSAPublicKey");
+        // at most 31 bits: a set top bit is a negative INTEGER, and would overflow e
+        if (vE.value[0] & 0x80) throw std::invalid_argument("bad public exponent");
+
+        this->n = new BigInteger();
+        this->n->fromBytes(vN.value, vN.length);
+
+        this->e = 0;
+        for (size_t i = 0; i < vE.length; i++) this->e = (this->e << 8) | vE.value[i];
+
+        if (this->n->t == 0 || (this->n->data[0] & 1) == 0) throw std::invalid_argument("RSA modulus must be odd");
+        if (this->e < 3 || (this->e & 1) == 0) throw std::invalid_argument("bad public exponent");
+    }
+    catch (std::exception& ex) {
+        delete(this->n);
+        this->n = NULL;
+        throw std::invalid_argument(std::string("malformed RSA public key: ") + ex.what());
+    }
+}
+
+void RSAPublicKey::prepare() {
+    std::call_once(this->prepared, [this]() {
+        RSALiteArenaScope heap(NULL);	// lives as long as the key
+
+        size_t k = this->signatureLength();
+        if (k < 11 + sizeof(SHA256_DIGEST_INFO) + 32) throw std::invalid_argument("RSA key too short for RS256");
+
+        this->encoded.assign(k - 32, 0xff);
+        this->encoded[0] = 0x00;
+        this->encoded[1] = 0x01;
+        this->encoded[k - 33 - sizeof(SHA256_DIGEST_INFO)] = 0x00;
+        std::memcpy(&this->encoded[k - 32 - sizeof(SHA256_DIGEST_INFO)], SHA256_DIGEST_INFO, sizeof(SHA256_DIGEST_INFO));
+
+        this->modulus.resize(k);
+        this->n->toBytes(this->modulus.data(), k);
+
+        this->fixed = RSAFixedVerifier::create(*this);
+        if (this->fixed != NULL) return;
+
+        this->mont = new Montgomery(this->n);
+        this->mont->prepareR2();
+        if (this->e != 65537) {
+            BigInteger e;
+            e.fromInt(this->e);
+            this->schedule = new ExpSchedule(e);
+        }
+    });
+}
+
+template<int Bits>
+static RSAFixedVerifier* _fixedVerifier(RSAPublicKey& key) {
+    std::vector<unsigned char> modulus(Bits / 8);
+    key.n->toBytes(modulus.data(), modulus.size());
+    return new RSAFixedVerifierOf<Bits>(modulus.data());
+}
+
+RSAFixedVerifier* RSAFixedVerifier::create(RSAPublicKey& key) {
+    int bits = key.n->bitLength();
+
+    if (bits > 1024 - 256 && bits <= 1024) return _fixedVerifier<1024>(key);
+    if (bits > 2048 - 256 && bits <= 2048) return _fixedVerifier<2048>(key);
+    if (bits > 3072 - 256 && bits <= 3072) return _fixedVerifier<3072>(key);
+    if (bits > 4096 - 256 && bits <= 4096) return _fixedVerifier<4096>(key);
+    return NULL;
+}
+
+size_t RSAPublicKey::signatureLength() {
+    return (this->n->bitLength() + 7) / 8;
+}
+
+// s^e mod n. For e = 65537 that is 16 squarings and one multiply by s, with
+// no window table to build
+BigInteger* RSAPublicKey::_publicOp(BigInteger& s) {
+    if (this->schedule != NULL) return s.modPow(*this->schedule, *this->mont);
+
+    BigInteger* sM = this->mont->convert(s);
+    BigInteger* r = BigInteger::nbi(), * r2 = BigInteger::nbi(), * t;
+
+    sM->copyTo(*r);
+    for (int i = 0; i < 16; i++) {
+        this->mont->sqrTo(*r, *r2);
+        t = r; r = r2; r2 = t;
+    }
+    this->mont->mulTo(*r, *sM, *r2);
+
+    BigInteger* ret = this->mont->revert(*r2);
+
+    delete(r);
+    delete(r2);
+    delete(sM);
+
+    return ret;
+}
+
+// EM is compared against the expected encoding as bytes; nothing is parsed
+// out of it, so there is no ASN.1 or padding leniency to exploit
+bool RSAPublicKey::verify(const unsigned char hash[32], const unsigned char* signature, size_t len) {
+    this->prepare();
+
+    size_t k = this->signatureLength();
+    if (len != k || std::memcmp(signature, this->modulus.data(), k) >= 0) return false;
+
+    std::vector<unsigned char> em(signature, signature + k);
+    if (this->fixed != NULL) {
+        this->fixed->verify(em.data(), k, this->e);
+    }
+    else {
+        BigInteger s;
+        s.fromBytes(em.data(), k);
+        BigInteger* m = this->_publicOp(s);
+        m->toBytes(em.data(), k);
+        delete(m);
+    }
+
+    return std::memcmp(em.data(), this->encoded.data(), k - 32) == 0 && std::memcmp(em.data() + k - 32, hash, 32) == 0;
+}
+
+// The key fixes the algorithm, so the header's "alg" is not consulted. The
+// signature has to be the canonical base64url of exactly k bytes
+bool RSALite::verifyJWT(const std::string& jwt, RSAPublicKey& key) {
+    size_t dot1 = jwt.find('.');
+    if (dot1 == std::string::npos) return false;
+    size_t dot2 = jwt.find('.', dot1 + 1);
+    if (dot2 == std::string::npos || jwt.find('.', dot2 + 1) != std::string::npos) return false;
+
+    const char* encodedSignature = jwt.data() + dot2 + 1;
+    size_t encodedLength = jwt.size() - dot2 - 1;
+    if (encodedLength != Digest::urlsafeB64Length(key.signatureLength())) return false;
+
+    std::vector<unsigned char> signature;
+    Digest::b64decode(encodedSignature, encodedLength, signature);
+    if (Digest::urlsafeB64Encode(std::string((const char*)signature.data(), signature.size())).compare(0, std::string::npos, encodedSignature, encodedLength) != 0)
+        return false;
+
+    unsigned char hash[32];
+    SHA256 sha;
+    sha.update(jwt.data(), dot2);
+    sha.final(hash);
+
+    return key.verify(hash, signature.data(), signature.size());
+}
+
+size_t RSALite::verifyJWTs(const std::vector<std::string>& jwts, RSAPublicKey& key, std::vector<char>& valid, int threads) {
+    valid.assign(jwts.size(), 0);
+    key.prepare();	// before the workers share it
+
+    if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+    threads = (int)std::min((size_t)threads, (jwts.size() + VERIFY_BATCH - 1) / VERIFY_BATCH);
+
+    std::atomic<size_t> next(0), verified(0);
+    auto worker = [&jwts, &key, &valid, &next, &verified]() {
+        size_t count = 0;
+        for (size_t i = next.fetch_add(VERIFY_BATCH); i < jwts.size(); i = next.fetch_add(VERIFY_BATCH)) {
+            for (size_t j = i; j < std::min(i + VERIFY_BATCH, jwts.size()); j++) {
+                valid[j] = RSALite::verifyJWT(jwts[j], key) ? 1 : 0;
+                count += valid[j];
+            }
+        }
+        verified += count;
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) workers.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+    return verified.load();
+}
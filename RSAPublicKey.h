@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include "RSALite.h"
+
+#ifndef RSAPUBLICKEY_H
+#define RSAPUBLICKEY_H
+
+class RSAFixedVerifier;
+
+// RSA public key from SPKI ("PUBLIC KEY") or PKCS#1 ("RSA PUBLIC KEY") for
+// RS256 verification. prepare() builds the Montgomery context for n (fixed
+// width when one fits) and the EMSA-PKCS1-v1_5 block up to the hash;
+// concurrent verify() calls share them.
+class RSAPublicKey
+{
+public:
+    BigInteger* n = NULL;
+    int e = 0;
+    RSAFixedVerifier* fixed = NULL;     // compile-time width for 1024 to 4096-bit moduli, else NULL
+
+    RSAPublicKey(std::string& pubKeyPEM);
+    RSAPublicKey(const unsigned char* der, size_t len);
+    RSAPublicKey(RSAKey& key);      // public half of a private key
+    ~RSAPublicKey();
+
+    void prepare();
+
+    // RSASSA-PKCS1-v1_5 over a SHA-256 hash; false for any signature not exactly signatureLength() bytes
+    bool verify(const unsigned char hash[32], const unsigned char* signature, size_t len);
+    size_t signatureLength();
+
+private:
+    std::once_flag prepared;
+    Montgomery* mont = NULL;
+    ExpSchedule* schedule = NULL;           // only for e != 65537
+    std::vector<unsigned char> modulus;     // n as k big-endian bytes, to range-check signatures
+    std::vector<unsigned char> encoded;     // 00 01 ff .. ff 00 DigestInfo, the first k - 32 bytes of EM
+
+    void _readDER(const unsigned char* der, size_t len);
+    BigInteger* _publicOp(BigInteger& s);
+};
+
+#endif
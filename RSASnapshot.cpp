@@ -0,0 +1,347 @@
+#include "RSASnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+const unsigned int RSASnapshot::VERSION = 3;
+const unsigned int RSASnapshot::ENDIAN_TAG = 0x01020304;
+
+static const char SNAPSHOT_MAGIC[8] = { 'R', 'S', 'L', 'S', 'N', 'A', 'P', 0 };
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t limbBits;
+    uint32_t limbSize;
+    uint32_t keyCount;
+    uint32_t reserved;
+    uint64_t payloadBytes;
+    uint64_t checksum;
+    unsigned char source[RSASnapshot::FINGERPRINT_BYTES];     // version 3 on
+};
+
+// versions 1 and 2 end at the checksum
+static const size_t SNAPSHOT_HEADER_V2 = offsetof(SnapshotHeader, source);
+
+class SnapshotWriter
+{
+public:
+    std::vector<unsigned char> buf;
+
+    void u32(uint32_t v) { this->bytes(&v, 4); }
+
+    void bytes(const void* v, size_t len) {
+        const unsigned char* b = (const unsigned char*)v;
+        this->buf.insert(this->buf.end(), b, b + len);
+    }
+
+    void pad() { while (this->buf.size() % 8 != 0) this->buf.push_back(0); }
+
+    void bi(BigInteger* x) {
+        this->u32(x->t);
+        this->u32((uint32_t)x->s);
+        this->bytes(x->data.data(), x->t * sizeof(unsigned int));
+        this->pad();
+    }
+
+    void schedule(ExpSchedule* x) {
+        this->u32(x->k);
+        this->u32((uint32_t)x->steps.size());
+        this->bytes(x->steps.data(), x->steps.size() * sizeof(int));
+        this->pad();
+    }
+};
+
+class SnapshotReader
+{
+public:
+    const unsigned char* p;
+    const unsigned char* end;
+
+    SnapshotReader(const unsigned char* p, const unsigned char* end) : p(p), end(end) {}
+
+    const unsigned char* take(size_t len) {
+        if (len > (size_t)(this->end - this->p)) throw std::invalid_argument("truncated snapshot record");
+        const unsigned char* r = this->p;
+        this->p += len;
+        return r;
+    }
+
+    uint32_t u32() {
+        uint32_t v;
+        std::memcpy(&v, this->take(4), 4);
+        return v;
+    }
+
+    void align(const unsigned char* base) { while ((this->p - base) % 8 != 0) this->take(1); }
+
+    BigInteger* bi(const unsigned char* base) {
+        uint32_t t = this->u32();
+        int32_t s = (int32_t)this->u32();
+        const unsigned char* limbs = this->take((size_t)t * sizeof(unsigned int));
+
+        BigInteger* x = new BigInteger();
+        x->data.resize(t);
+        if (t > 0) std::memcpy(x->data.data(), limbs, t * sizeof(unsigned int));
+        x->t = t;
+        x->s = s;
+        this->align(base);
+
+        return x;
+    }
+
+    ExpSchedule* schedule(const unsigned char* base) {
+        ExpSchedule* x = new ExpSchedule();
+        x->k = this->u32();
+        uint32_t count = this->u32();
+        const unsigned char* steps = this->take((size_t)count * sizeof(int));
+
+        x->steps.resize(count);
+        if (count > 0) std::memcpy(x->steps.data(), steps, count * sizeof(int));
+        this->align(base);
+
+        if (x->k < 0 || x->k > ExpSchedule::MAX_WINDOW || count % 2 != 0) {
+            delete(x);
+            throw std::invalid_argument("bad exponent schedule");
+        }
+        for (uint32_t i = 1; i < count; i += 2) {
+            int w = x->steps[i];
+            if (w < 0 || w >= (1 << x->k) || (w != 0 && (w & 1) == 0) || (i == 1 && w == 0) || x->steps[i - 1] < 0) {
+                delete(x);
+                throw std::invalid_argument("bad exponent schedule");
+            }
+        }
+
+        return x;
+    }
+};
+
+// Keys are prepared first, on `threads` threads, so the image always carries
+// the full precomputation
+void RSASnapshot::write(const std::string& path, std::vector<std::string>& names, std::vector<RSAKey*>& keys, const std::string& source,
+    unsigned threads) {
+    _prepareAll(keys, threads);
+
+    SnapshotWriter w;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        RSAKey* key = keys[i];
+
+        size_t start = w.buf.size();
+        w.u32(0);	// record size, patched below
+        w.u32((uint32_t)names[i].size());
+        w.bytes(names[i].data(), names[i].size());
+        w.pad();
+        w.u32((uint32_t)key->e);
+        w.u32(0);
+        w.bi(key->n);
+        w.bi(key->d);
+        w.bi(key->p);
+        w.bi(key->q);
+        w.bi(key->dmp1);
+        w.bi(key->dmq1);
+        w.bi(key->coeff);
+        w.bi(key->pMont->r2);
+        w.bi(key->qMont->r2);
+        w.schedule(key->dmp1Schedule);
+        w.schedule(key->dmq1Schedule);
+        w.u32((uint32_t)key->otherPrimes.size());
+        w.u32(0);
+        for (size_t j = 0; j < key->otherPrimes.size(); j++) {
+            RSAOtherPrime& o = key->otherPrimes[j];
+            w.bi(o.r);
+            w.bi(o.d);
+            w.bi(o.t);
+            w.bi(o.mont->r2);
+            w.schedule(o.schedule);
+        }
+
+        uint32_t recordBytes = (uint32_t)(w.buf.size() - start);
+        std::memcpy(&w.buf[start], &recordBytes, 4);
+    }
+
+    SnapshotHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, SNAPSHOT_MAGIC, 8);
+    h.version = VERSION;
+    h.endianTag = ENDIAN_TAG;
+    h.limbBits = BigInteger::DB;
+    h.limbSize = sizeof(unsigned int);
+    h.keyCount = (uint32_t)keys.size();
+    h.payloadBytes = w.buf.size();
+    h.checksum = _checksum(w.buf.data(), w.buf.size());
+    std::memcpy(h.source, source.data(), std::min(source.size(), sizeof(h.source)));
+
+    // write aside and rename so readers never map a half-written image
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) throw std::invalid_argument("can't write snapshot " + tmp);
+
+        out.write((const char*)&h, sizeof(h));
+        out.write((const char*)w.buf.data(), w.buf.size());
+        if (!out) throw std::invalid_argument("can't write snapshot " + tmp);
+    }
+
+    // replaces the old image in one step, which stays in place if this fails
+#ifdef _WIN32
+    bool replaced = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool replaced = std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+    if (!replaced) {
+        std::remove(tmp.c_str());
+        throw std::invalid_argument("can't replace snapshot " + path);
+    }
+}
+
+bool RSASnapshot::read(const unsigned char* data, size_t len, std::vector<std::string>& names, std::vector<RSAKey*>& keys, std::string& error,
+    const std::string& source) {
+    SnapshotHeader h;
+    std::memset(&h, 0, sizeof(h));
+
+    if (data == NULL || len < SNAPSHOT_HEADER_V2) { error = "snapshot too short"; return false; }
+    std::memcpy(&h, data, SNAPSHOT_HEADER_V2);
+
+    if (std::memcmp(h.magic, SNAPSHOT_MAGIC, 8) != 0) { error = "not a snapshot"; return false; }
+    if (h.version < 1 || h.version > VERSION) { error = "unsupported snapshot version"; return false; }
+
+    size_t headerBytes = h.version >= 3 ? sizeof(h) : SNAPSHOT_HEADER_V2;
+    if (len < headerBytes) { error = "snapshot too short"; return false; }
+    std::memcpy(&h, data, headerBytes);
+
+    if (h.endianTag != ENDIAN_TAG) { error = "snapshot byte order mismatch"; return false; }
+    if (h.limbBits != (uint32_t)BigInteger::DB || h.limbSize != sizeof(unsigned int)) { error = "snapshot limb layout mismatch"; return false; }
+    if (h.payloadBytes != len - headerBytes) { error = "snapshot size mismatch"; return false; }
+
+    const unsigned char* payload = data + headerBytes;
+    if (_checksum(payload, (size_t)h.payloadBytes) != h.checksum) { error = "snapshot checksum mismatch"; return false; }
+
+    // older images carry no fingerprint, so they can't be matched to a source
+    if (!source.empty() && (h.version < 3 || source.size() != sizeof(h.source) || std::memcmp(h.source, source.data(), sizeof(h.source)) != 0)) {
+        error = "snapshot is out of date with its source";
+        return false;
+    }
+
+    RSALiteArenaScope heap(NULL);	// restored keys outlive any arena the caller has in scope
+    std::vector<std::string> newNames;
+    std::vector<RSAKey*> newKeys;
+    SnapshotReader r(payload, payload + h.payloadBytes);
+
+    try {
+        for (uint32_t i = 0; i < h.keyCount; i++) {
+            const unsigned char* base = r.p;
+            uint32_t recordBytes = r.u32();
+            if (recordBytes < 8 || recordBytes % 8 != 0) throw std::invalid_argument("bad snapshot record size");
+
+            r.p = base;
+            r.take(recordBytes);
+
+            SnapshotReader rr(base + 4, base + recordBytes);
+            uint32_t nameLen = rr.u32();
+            std::string name((const char*)rr.take(nameLen), nameLen);
+            rr.align(base);
+
+            RSAKey* key = new RSAKey();
+            newKeys.push_back(key);
+            newNames.push_back(name);
+
+            key->e = (int)rr.u32();
+            rr.u32();
+            key->n = rr.bi(base);
+            key->d = rr.bi(base);
+            key->p = rr.bi(base);
+            key->q = rr.bi(base);
+            key->dmp1 = rr.bi(base);
+            key->dmq1 = rr.bi(base);
+            key->coeff = rr.bi(base);
+
+            if (key->p->t == 0 || key->q->t == 0 || (key->p->data[0] & 1) == 0 || (key->q->data[0] & 1) == 0) {
+                throw std::invalid_argument("bad CRT primes");
+            }
+
+            key->pMont = new Montgomery(key->p);
+            key->qMont = new Montgomery(key->q);
+            key->pMont->r2 = rr.bi(base);
+            key->qMont->r2 = rr.bi(base);
+            key->dmp1Schedule = rr.schedule(base);
+            key->dmq1Schedule = rr.schedule(base);
+
+            // version 1 images predate multi-prime keys
+            uint32_t others = 0;
+            if (h.version >= 2) {
+                others = rr.u32();
+                rr.u32();
+            }
+
+            for (uint32_t j = 0; j < others; j++) {
+                key->otherPrimes.push_back(RSAOtherPrime());
+                RSAOtherPrime& o = key->otherPrimes.back();
+                o.r = rr.bi(base);
+                o.d = rr.bi(base);
+                o.t = rr.bi(base);
+                if (o.r->t == 0 || (o.r->data[0] & 1) == 0) throw std::invalid_argument("bad CRT primes");
+
+                o.mont = new Montgomery(o.r);
+                o.mont->r2 = rr.bi(base);
+                o.schedule = rr.schedule(base);
+            }
+        }
+        if (r.p != r.end) throw std::invalid_argument("trailing snapshot data");
+    }
+    catch (std::exception& e) {
+        for (size_t i = 0; i < newKeys.size(); i++) delete(newKeys[i]);
+        error = e.what();
+        return false;
+    }
+
+    names.insert(names.end(), newNames.begin(), newNames.end());
+    keys.insert(keys.end(), newKeys.begin(), newKeys.end());
+
+    return true;
+}
+
+// FNV-1a 64
+void RSASnapshot::_prepareAll(std::vector<RSAKey*>& keys, unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > keys.size()) threads = (unsigned)std::max<size_t>(keys.size(), 1);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&keys, &next]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < keys.size()) {
+            keys[i]->prepare();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) pool.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
+
+unsigned long long RSASnapshot::_checksum(const unsigned char* data, size_t len) {
+    unsigned long long h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "RSALite.h"
+
+#ifndef RSASNAPSHOT_H
+#define RSASNAPSHOT_H
+
+// Binary image of prepared RSA keys: key integers, R^2 mod p/q and the CRT
+// exponent schedules, stored as native-endian limbs in 8-byte aligned records.
+//
+//   header  magic "RSLSNAP", version, endian tag, limb bits/size, key count,
+//           payload size, FNV-1a 64 checksum of the payload, fingerprint of
+//           the source the keys were parsed from (version 3 on)
+//   record  size, name, e, n, d, p, q, dP, dQ, qInv, R^2 mod p, R^2 mod q,
+//           dP schedule, dQ schedule, other prime count, then per other prime
+//           r, d, t, R^2 mod r and its schedule (version 2 on)
+//
+// Loading copies limbs straight into the keys, no parsing or bignum work.
+// Any header, checksum or bounds mismatch rejects the whole image, and so
+// does a source fingerprint other than the one the caller expects.
+class RSASnapshot
+{
+public:
+    static const unsigned int VERSION;
+    static const unsigned int ENDIAN_TAG;
+
+    static const size_t FINGERPRINT_BYTES = 32;
+
+    // source is RSAKeystore::fingerprint() of where the keys came from, or
+    // empty; keys not yet prepared are prepared on `threads` threads, 0 for one per core
+    static void write(const std::string& path, std::vector<std::string>& names, std::vector<RSAKey*>& keys, const std::string& source = "",
+        unsigned threads = 0);
+    static bool read(const unsigned char* data, size_t len, std::vector<std::string>& names, std::vector<RSAKey*>& keys, std::string& error,
+        const std::string& source = "");
+
+private:
+    static void _prepareAll(std::vector<RSAKey*>& keys, unsigned threads);
+    static unsigned long long _checksum(const unsigned char* data, size_t len);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "SigningQueue.h"
+#include <algorithm>
+
+// std heaps keep the largest element on top, so "later" sorts first
+bool SigningQueue::_Later::operator()(const Request& a, const Request& b) const {
+    if (a.deadline != b.deadline) return a.deadline > b.deadline;
+    return a.sequence > b.sequence;
+}
+
+SigningQueue::SigningQueue(unsigned threads, size_t capacity) {
+    if (threads == 0) throw std::invalid_argument("signing queue needs at least one thread");
+
+    this->limit = capacity;
+    this->heap.reserve(capacity);
+
+    for (unsigned i = 0; i < threads; i++) {
+        this->workers.push_back(std::thread(&SigningQueue::_run, this));
+    }
+}
+
+SigningQueue::~SigningQueue() {
+    std::vector<Request> abandoned;
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+        abandoned.swap(this->heap);
+    }
+    this->ready.notify_all();
+
+    for (size_t i = 0; i < this->workers.size(); i++) this->workers[i].join();
+
+    std::exception_ptr stopped = std::make_exception_ptr(Rejected("signing queue stopped"));
+    for (size_t i = 0; i < abandoned.size(); i++) _complete(abandoned[i], std::string(), stopped);
+}
+
+bool SigningQueue::_enqueue(std::function<std::string()> sign, Callback done, Clock::time_point deadline) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+
+        if (this->stopping || this->heap.size() >= this->limit) {
+            this->rejectedCount++;
+            return false;
+        }
+
+        Request request;
+        request.deadline = deadline;
+        request.sequence = this->sequence++;
+        request.sign = std::move(sign);
+        request.done = std::move(done);
+
+        this->heap.push_back(std::move(request));
+        std::push_heap(this->heap.begin(), this->heap.end(), _Later());
+    }
+    this->ready.notify_one();
+
+    return true;
+}
+
+void SigningQueue::_run() {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    for (;;) {
+        this->ready.wait(guard, [this]() { return this->stopping || !this->heap.empty(); });
+        if (this->stopping) return;
+
+        std::pop_heap(this->heap.begin(), this->heap.end(), _Later());
+        Request request = std::move(this->heap.back());
+        this->heap.pop_back();
+
+        bool late = request.deadline != noDeadline() && Clock::now() > request.deadline;
+        if (late) this->expiredCount++;
+        guard.unlock();
+
+        if (late) {
+            _complete(request, std::string(), std::make_exception_ptr(DeadlineExceeded()));
+        }
+        else {
+            std::string jwt;
+            std::exception_ptr error;
+
+            try {
+                jwt = request.sign();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            _complete(request, jwt, error);
+        }
+
+        guard.lock();
+    }
+}
+
+// A throwing callback must not take the signer thread down with it
+void SigningQueue::_complete(Request& request, const std::string& jwt, std::exception_ptr error) {
+    try {
+        request.done(jwt, error);
+    }
+    catch (...) {
+    }
+}
+
+size_t SigningQueue::pending() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->heap.size();
+}
+
+size_t SigningQueue::capacity() const {
+    return this->limit;
+}
+
+uint64_t SigningQueue::rejected() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->rejectedCount;
+}
+
+uint64_t SigningQueue::expired() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->expiredCount;
+}
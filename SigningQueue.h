@@ -0,0 +1,155 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RSALite.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define RSALITE_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef SIGNINGQUEUE_H
+#define SIGNINGQUEUE_H
+
+// Signs JWTs on dedicated threads so event-loop callers never block on a
+// private-key operation. Pending requests are ordered earliest deadline
+// first (FIFO among equal deadlines, requests without one go last) and the
+// queue is bounded: when it is full a request is rejected at submission
+// instead of waiting. A request still queued when its deadline passes fails
+// with DeadlineExceeded without being signed.
+//
+// Completion callbacks run on a signer thread and must not throw. Keys are
+// borrowed and must outlive every request that uses them.
+class SigningQueue
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void(const std::string& jwt, std::exception_ptr error)> Callback;
+
+    class Rejected : public std::runtime_error
+    {
+    public:
+        Rejected(const std::string& what) : std::runtime_error(what) {}
+    };
+
+    class DeadlineExceeded : public std::runtime_error
+    {
+    public:
+        DeadlineExceeded() : std::runtime_error("signing deadline exceeded") {}
+    };
+
+    static Clock::time_point noDeadline() { return Clock::time_point::max(); }
+
+    SigningQueue(unsigned threads = 1, size_t capacity = 64);
+    ~SigningQueue();    // finishes the requests being signed, fails the rest with Rejected
+
+    // false when the queue is full; done is then never called
+    template<typename Key>
+    bool trySubmit(const std::string& header, const std::string& payload, Key& key, Callback done, Clock::time_point deadline = noDeadline()) {
+        return this->_enqueue([header, payload, &key]() { return RSALite::createJWT(header, payload, key); }, std::move(done), deadline);
+    }
+
+    // a rejected request comes back as a future that already holds Rejected
+    template<typename Key>
+    std::future<std::string> submit(const std::string& header, const std::string& payload, Key& key, Clock::time_point deadline = noDeadline()) {
+        std::shared_ptr<std::promise<std::string> > promise = std::make_shared<std::promise<std::string> >();
+        std::future<std::string> result = promise->get_future();
+
+        Callback done = [promise](const std::string& jwt, std::exception_ptr error) {
+            if (error) promise->set_exception(error);
+            else promise->set_value(jwt);
+        };
+        if (!this->trySubmit(header, payload, key, done, deadline)) {
+            promise->set_exception(std::make_exception_ptr(Rejected("signing queue full")));
+        }
+
+        return result;
+    }
+
+#ifdef RSALITE_HAS_COROUTINES
+    // co_await queue.sign(header, payload, key): the coroutine resumes on a signer thread
+    class Awaiter
+    {
+    public:
+        Awaiter(std::function<bool(Callback)> enqueue) : enqueue(std::move(enqueue)) {}
+
+        bool await_ready() { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            bool accepted = this->enqueue([this, handle](const std::string& jwt, std::exception_ptr error) {
+                this->jwt = jwt;
+                this->error = error;
+                handle.resume();
+            });
+            if (!accepted) this->error = std::make_exception_ptr(Rejected("signing queue full"));
+
+            return accepted;
+        }
+
+        std::string await_resume() {
+            if (this->error) std::rethrow_exception(this->error);
+            return std::move(this->jwt);
+        }
+
+    private:
+        std::function<bool(Callback)> enqueue;
+        std::string jwt;
+        std::exception_ptr error;
+    };
+
+    template<typename Key>
+    Awaiter sign(const std::string& header, const std::string& payload, Key& key, Clock::time_point deadline = noDeadline()) {
+        return Awaiter([this, header, payload, &key, deadline](Callback done) {
+            return this->trySubmit(header, payload, key, std::move(done), deadline);
+        });
+    }
+#endif
+
+    size_t pending();
+    size_t capacity() const;
+    uint64_t rejected();    // turned away because the queue was full
+    uint64_t expired();     // dropped at their deadline
+
+private:
+    struct Request {
+        Clock::time_point deadline;
+        uint64_t sequence;
+        std::function<std::string()> sign;
+        Callback done;
+    };
+
+    struct _Later {
+        bool operator()(const Request& a, const Request& b) const;
+    };
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<Request> heap;          // min-heap on (deadline, sequence)
+    std::vector<std::thread> workers;
+    size_t limit;
+    uint64_t sequence = 0;
+    uint64_t rejectedCount = 0;
+    uint64_t expiredCount = 0;
+    bool stopping = false;
+
+    bool _enqueue(std::function<std::string()> sign, Callback done, Clock::time_point deadline);
+    void _run();
+    static void _complete(Request& request, const std::string& jwt, std::exception_ptr error);
+
+    SigningQueue(const SigningQueue&);
+    SigningQueue& operator=(const SigningQueue&);
+};
+
+#endif
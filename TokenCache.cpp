@@ -0,0 +1,176 @@
+#include "TokenCache.h"
+#include <cctype>
+#include <stdexcept>
+
+TokenCache::TokenCache(size_t capacity, unsigned shards, std::chrono::seconds margin) {
+    if (shards == 0) throw std::invalid_argument("token cache needs at least one shard");
+
+    this->shards.reset(new Shard[shards]);
+    this->shardCount = shards;
+    this->shardCapacity = (capacity + shards - 1) / shards;
+    this->margin = margin;
+}
+
+std::string TokenCache::_get(const std::string& keyId, const std::string& header, const std::string& payload, const std::function<std::string()>& sign) {
+    Clock::time_point now = Clock::now();
+    Clock::time_point expiry = Clock::time_point::max();
+    long long exp;
+    ExpState state = expClaim(payload, exp);
+
+    // exp beyond what the clock represents is as good as none; one that
+    // can't be read could mean any time, so it is treated as already past
+    if (state == EXP_UNPARSABLE) expiry = now;
+    else if (state == EXP_VALID && exp < std::chrono::duration_cast<std::chrono::seconds>(Clock::time_point::max().time_since_epoch()).count()) {
+        expiry = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(exp))) - this->margin;
+    }
+
+    std::string signingInput = Digest::urlsafeB64Encode(header) + "." + Digest::urlsafeB64Encode(payload);
+    unsigned char hash[32];
+    SHA256 sha;
+    sha.update(signingInput.data(), signingInput.size());
+    sha.final(hash);
+
+    std::string id = keyId;
+    id.push_back('\0');
+    id.append((const char*)hash, 32);
+
+    Shard& shard = this->shards[(hash[0] | (hash[1] << 8)) % this->shardCount];
+    std::promise<std::string> minted;
+
+    {
+        std::unique_lock<std::mutex> guard(shard.lock);
+
+        auto found = shard.index.find(id);
+        if (found != shard.index.end()) {
+            std::list<Entry>::iterator entry = found->second;
+
+            if (entry->expiry > now) {
+                shard.counts.hits++;
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+                std::shared_future<std::string> jwt = entry->jwt;
+
+                guard.unlock();
+                return jwt.get();
+            }
+
+            shard.counts.expirations++;
+            shard.index.erase(found);
+            shard.lru.erase(entry);
+        }
+
+        if (expiry <= now) {
+            shard.counts.uncacheable++;
+            guard.unlock();
+            return sign();
+        }
+
+        shard.counts.misses++;
+
+        while (!shard.lru.empty() && shard.lru.size() >= this->shardCapacity) {
+            shard.counts.evictions++;
+            shard.index.erase(shard.lru.back().id);
+            shard.lru.pop_back();
+        }
+
+        Entry entry;
+        entry.id = id;
+        entry.jwt = minted.get_future().share();
+        entry.expiry = expiry;
+        entry.minter = &minted;
+        shard.lru.push_front(entry);
+        shard.index[id] = shard.lru.begin();
+    }
+
+    try {
+        std::string jwt = sign();
+        minted.set_value(jwt);
+        return jwt;
+    }
+    catch (...) {
+        minted.set_exception(std::current_exception());
+
+        // forget the failure so the next caller tries again
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.index.find(id);
+        if (found != shard.index.end() && found->second->minter == &minted) {
+            shard.lru.erase(found->second);
+            shard.index.erase(found);
+        }
+        throw;
+    }
+}
+
+void TokenCache::clear() {
+    for (unsigned i = 0; i < this->shardCount; i++) {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        this->shards[i].lru.clear();
+        this->shards[i].index.clear();
+    }
+}
+
+TokenCacheStats TokenCache::stats() {
+    TokenCacheStats total;
+
+    for (unsigned i = 0; i < this->shardCount; i++) {
+        std::lock_guard<std::mutex> guard(this->shards[i].lock);
+        const TokenCacheStats& c = this->shards[i].counts;
+
+        total.hits += c.hits;
+        total.misses += c.misses;
+        total.uncacheable += c.uncacheable;
+        total.evictions += c.evictions;
+        total.expirations += c.expirations;
+        total.entries += this->shards[i].lru.size();
+    }
+
+    return total;
+}
+
+// Only a member of the top-level object counts: nested objects and arrays
+// are stepped over by depth and string contents are skipped, escapes included
+TokenCache::ExpState TokenCache::expClaim(const std::string& payload, long long& exp) {
+    int depth = 0;
+
+    for (size_t i = 0; i < payload.size(); i++) {
+        char c = payload[i];
+
+        if (c == '{' || c == '[') depth++;
+        else if (c == '}' || c == ']') depth--;
+        if (c != '"') continue;
+
+        size_t begin = ++i;
+        while (i < payload.size() && payload[i] != '"') i += payload[i] == '\\' ? 2 : 1;
+        if (i >= payload.size()) return EXP_ABSENT;
+        if (depth != 1 || payload.compare(begin, i - begin, "exp") != 0) continue;
+
+        // a member name when a colon follows, else the string value "exp"
+        size_t j = i + 1;
+        while (j < payload.size() && std::isspace((unsigned char)payload[j])) j++;
+        if (j >= payload.size() || payload[j] != ':') continue;
+        j++;
+        while (j < payload.size() && std::isspace((unsigned char)payload[j])) j++;
+
+        // NumericDate: whole seconds, any fraction dropped; past 18 digits it
+        // saturates, which is beyond the clock anyway
+        size_t digits = j;
+        long long value = 0;
+        while (j < payload.size() && payload[j] >= '0' && payload[j] <= '9') {
+            if (j - digits < 18) value = value * 10 + (payload[j] - '0');
+            j++;
+        }
+        if (j == digits) return EXP_UNPARSABLE;
+        if (j < payload.size() && payload[j] == '.') {
+            size_t fraction = ++j;
+            while (j < payload.size() && payload[j] >= '0' && payload[j] <= '9') j++;
+            if (j == fraction) return EXP_UNPARSABLE;
+        }
+
+        while (j < payload.size() && std::isspace((unsigned char)payload[j])) j++;
+        if (j >= payload.size() || (payload[j] != ',' && payload[j] != '}')) return EXP_UNPARSABLE;
+
+        exp = value;
+        return EXP_VALID;
+    }
+
+    return EXP_ABSENT;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "RSALite.h"
+
+#ifndef TOKENCACHE_H
+#define TOKENCACHE_H
+
+struct TokenCacheStats
+{
+    uint64_t hits = 0;          // includes callers that waited for a mint already in flight
+    uint64_t misses = 0;
+    uint64_t uncacheable = 0;   // exp already inside the safety margin, or not a number; signed but not kept
+    uint64_t evictions = 0;     // dropped for space
+    uint64_t expirations = 0;   // dropped at exp minus the margin
+    size_t entries = 0;
+};
+
+// Signed-JWT cache keyed by (key id, SHA-256 of the signing input). Every
+// supported algorithm signs deterministically, so a hit returns exactly the
+// token a fresh createJWT would. An entry lives until the payload's "exp"
+// claim minus the safety margin (tokens without exp never expire, tokens
+// with an exp that isn't a NumericDate are never kept) or until
+// its shard runs out of room, least recently used first. Concurrent misses
+// on one token mint it once; the other callers wait for that signature.
+class TokenCache
+{
+public:
+    typedef std::chrono::system_clock Clock;
+
+    TokenCache(size_t capacity = 1024, unsigned shards = 16, std::chrono::seconds margin = std::chrono::seconds(30));
+
+    // the key id names the key; the same id must always mean the same key
+    template<typename Key>
+    std::string createJWT(const std::string& keyId, const std::string& header, const std::string& payload, Key& key) {
+        return this->_get(keyId, header, payload, [&header, &payload, &key]() { return RSALite::createJWT(header, payload, key); });
+    }
+
+    void clear();
+    TokenCacheStats stats();
+
+    enum ExpState { EXP_ABSENT, EXP_VALID, EXP_UNPARSABLE };
+
+    // the payload's top-level "exp" claim (seconds since the epoch), found by a
+    // scan that tracks nesting and strings rather than a full JSON parse. exp
+    // is only set for EXP_VALID; a string, null or negative exp is EXP_UNPARSABLE
+    static ExpState expClaim(const std::string& payload, long long& exp);
+
+private:
+    struct Entry {
+        std::string id;
+        std::shared_future<std::string> jwt;
+        Clock::time_point expiry;
+        const void* minter;         // the miss that is signing it
+    };
+
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::list<Entry> lru;       // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        TokenCacheStats counts;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    unsigned shardCount;
+    size_t shardCapacity;
+    std::chrono::seconds margin;
+
+    std::string _get(const std::string& keyId, const std::string& header, const std::string& payload, const std::function<std::string()>& sign);
+
+    TokenCache(const TokenCache&);
+    TokenCache& operator=(const TokenCache&);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "TokenRefresher.h"
+#include <stdexcept>
+
+uint64_t TokenRefresher::Slot::mints() const {
+    return this->minted.load();
+}
+
+uint64_t TokenRefresher::Slot::failures() const {
+    return this->failed.load();
+}
+
+TokenRefresher::TokenRefresher() {
+    this->worker = std::thread(&TokenRefresher::_run, this);
+}
+
+TokenRefresher::~TokenRefresher() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->worker.join();
+}
+
+std::string TokenRefresher::withTimes(const std::string& claims, long long iat, long long exp) {
+    size_t open = claims.find('{');
+    size_t close = claims.rfind('}');
+    if (open == std::string::npos || close == std::string::npos || close < open) {
+        throw std::invalid_argument("claims template must be a JSON object");
+    }
+
+    bool empty = claims.find_first_not_of(" \t\r\n", open + 1) == close;
+    std::string times = "\"iat\":" + std::to_string(iat) + ",\"exp\":" + std::to_string(exp);
+
+    return claims.substr(0, close) + (empty ? "" : ",") + times + claims.substr(close);
+}
+
+// Signs one replacement and publishes it; returns when the slot is due again
+TokenRefresher::Clock::time_point TokenRefresher::_mint(Slot& slot) {
+    Clock::time_point started = Clock::now();
+    long long iat = std::chrono::duration_cast<std::chrono::seconds>(WallClock::now().time_since_epoch()).count();
+
+    try {
+        std::shared_ptr<Token> token = std::make_shared<Token>();
+        token->iat = iat;
+        token->exp = iat + slot.lifetime.count();
+        token->jwt = slot.sign(slot.header, withTimes(slot.claims, token->iat, token->exp));
+
+        std::atomic_store(&slot.token, std::shared_ptr<const Token>(token));
+        slot.minted++;
+    }
+    catch (...) {
+        slot.failed++;
+        if (!slot.token) throw;
+
+        return Clock::now() + std::chrono::seconds(1);
+    }
+
+    return started + slot.lifetime - slot.refreshBefore;
+}
+
+void TokenRefresher::_add(const std::shared_ptr<Slot>& slot) {
+    if (slot->refreshBefore >= slot->lifetime) throw std::invalid_argument("refreshBefore must be shorter than the token lifetime");
+
+    Clock::time_point due = _mint(*slot);
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        slot->due = due;
+        this->slots.push_back(slot);
+    }
+    this->wake.notify_all();
+}
+
+// Returns once no mint of the slot is under way, so its key may go right after;
+// from inside the slot's own sign callback it can't wait for itself
+void TokenRefresher::remove(const std::shared_ptr<Slot>& slot) {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    for (size_t i = 0; i < this->slots.size(); i++) {
+        if (this->slots[i] != slot) continue;
+
+        this->slots.erase(this->slots.begin() + i);
+        break;
+    }
+
+    if (std::this_thread::get_id() == this->worker.get_id()) return;
+    this->wake.wait(guard, [this, &slot]() { return this->minting != slot.get(); });
+}
+
+void TokenRefresher::_run() {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (!this->stopping) {
+        std::shared_ptr<Slot> next;
+        for (size_t i = 0; i < this->slots.size(); i++) {
+            if (!next || this->slots[i]->due < next->due) next = this->slots[i];
+        }
+
+        if (!next) {
+            this->wake.wait(guard);
+            continue;
+        }
+        if (next->due > Clock::now()) {
+            this->wake.wait_until(guard, next->due);
+            continue;
+        }
+
+        this->minting = next.get();
+        guard.unlock();
+        Clock::time_point due = _mint(*next);
+        guard.lock();
+
+        next->due = due;
+        this->minting = NULL;
+        this->wake.notify_all();
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RSALite.h"
+
+#ifndef TOKENREFRESHER_H
+#define TOKENREFRESHER_H
+
+// Keeps service tokens fresh in the background. Each registration is a
+// header plus a claims template; a mint adds "iat" (now) and "exp" (now +
+// lifetime) to the template and signs it. The first token is minted by
+// add(), replacements on the refresher's thread refreshBefore ahead of exp,
+// and each is published with an atomic shared_ptr store, so the request path
+// is Slot::current(), a single atomic load. A failed mint keeps the old
+// token and is retried a second later.
+class TokenRefresher
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::system_clock WallClock;   // iat / exp
+
+    struct Token
+    {
+        std::string jwt;
+        long long iat;
+        long long exp;
+    };
+
+    class Slot
+    {
+    public:
+        std::shared_ptr<const Token> current() const { return std::atomic_load(&this->token); }
+
+        uint64_t mints() const;
+        uint64_t failures() const;
+
+    private:
+        std::string header;
+        std::string claims;
+        std::chrono::seconds lifetime;
+        std::chrono::milliseconds refreshBefore;
+        std::function<std::string(const std::string&, const std::string&)> sign;
+
+        std::shared_ptr<const Token> token;
+        Clock::time_point due;              // guarded by the refresher's lock
+        std::atomic<uint64_t> minted{ 0 };
+        std::atomic<uint64_t> failed{ 0 };
+
+        friend class TokenRefresher;
+    };
+
+    TokenRefresher();
+    ~TokenRefresher();
+
+    // claims is a JSON object without iat / exp; refreshBefore must be shorter
+    // than lifetime and the key must stay alive until the slot is removed
+    template<typename Key>
+    std::shared_ptr<Slot> add(const std::string& header, const std::string& claims, Key& key, std::chrono::seconds lifetime,
+        std::chrono::milliseconds refreshBefore = std::chrono::seconds(60)) {
+        std::shared_ptr<Slot> slot = std::make_shared<Slot>();
+        slot->header = header;
+        slot->claims = claims;
+        slot->lifetime = lifetime;
+        slot->refreshBefore = refreshBefore;
+        slot->sign = [&key](const std::string& h, const std::string& p) { return RSALite::createJWT(h, p, key); };
+
+        this->_add(slot);
+        return slot;
+    }
+
+    // waits for a mint of the slot already under way; the key may be destroyed after
+    void remove(const std::shared_ptr<Slot>& slot);
+
+    // the template with "iat" and "exp" appended
+    static std::string withTimes(const std::string& claims, long long iat, long long exp);
+
+private:
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<std::shared_ptr<Slot> > slots;
+    std::thread worker;
+    Slot* minting = NULL;           // the slot _run() is signing outside the lock
+    bool stopping = false;
+
+    void _add(const std::shared_ptr<Slot>& slot);
+    static Clock::time_point _mint(Slot& slot);
+    void _run();
+
+    TokenRefresher(const TokenRefresher&);
+    TokenRefresher& operator=(const TokenRefresher&);
+};
+
+#endif
@@ -0,0 +1,629 @@
+#include "../RSALite.h"
+#include "../P256.h"
+#include "../Ed25519.h"
+#include "../TokenCache.h"
+#include "../ClaimsBuilder.h"
+#include "../FixedBigInt.h"
+#include "../RSAPublicKey.h"
+#include "BenchKeys.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for the signing hot paths.
+//
+//   rsalite_bench [--quick] [--filter text] [--min-ms n] [--samples n]
+//                 [--json out.json] [--baseline base.json] [--threshold pct]
+//
+// Each benchmark is calibrated to run for about --min-ms per sample; the
+// reported figure is the median ns/op over --samples samples. With
+// --baseline the results are compared against an earlier --json file and
+// the exit status is 1 when any benchmark got slower by more than
+// --threshold percent (default 10).
+//
+// In RSALITE_COUNTERS builds every result also carries the exact operation
+// counts of a single op; any count above the baseline is a regression
+// regardless of timing noise.
+
+struct BenchResult
+{
+    std::string name;
+    double nsPerOp = 0;
+    unsigned long long iterations = 0;
+    size_t bytes = 0;           // bytes processed per op, 0 if not a throughput benchmark
+    bool hasCounters = false;
+    RSALiteCounters counters;   // one op, RSALITE_COUNTERS builds only
+};
+
+struct CounterField
+{
+    const char* name;           // JSON key
+    uint64_t RSALiteCounters::* field;
+};
+
+static const CounterField COUNTERS[] = {
+    { "am_iterations", &RSALiteCounters::amIterations },
+    { "multiply_to", &RSALiteCounters::multiplyTo },
+    { "square_to", &RSALiteCounters::squareTo },
+    { "reduce", &RSALiteCounters::reduce },
+    { "div_rem_to", &RSALiteCounters::divRemTo },
+    { "big_integers", &RSALiteCounters::bigIntegers },
+    { "allocations", &RSALiteCounters::allocations },
+    { "bytes_allocated", &RSALiteCounters::bytesAllocated },
+    { "digest_blocks", &RSALiteCounters::digestBlocks },
+};
+static const int COUNTER_FIELDS = sizeof(COUNTERS) / sizeof(COUNTERS[0]);
+
+struct BenchOptions
+{
+    bool quick = false;
+    std::string filter;
+    double minMillis = 200;
+    int samples = 5;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10;
+    int maxThreads = 64;
+};
+
+static volatile unsigned int benchSink;
+
+// One worker's scratch and op count in runThreads, on its own cache lines
+struct alignas(64) BenchLane
+{
+    char out[1024];
+    unsigned long long ops = 0;
+};
+
+class Bench
+{
+public:
+    BenchOptions options;
+    std::vector<BenchResult> results;
+
+    Bench(const BenchOptions& options) : options(options) {}
+
+    template<typename F>
+    void run(const std::string& name, size_t bytes, F f) {
+        if (!this->options.filter.empty() && name.find(this->options.filter) == std::string::npos) return;
+
+        // one warm-up call, then size the batch to fill a sample
+        double once = this->_time(f, 1);
+        unsigned long long iterations = 1;
+        if (once > 0) iterations = (unsigned long long)std::max(1.0, this->options.minMillis * 1e6 / once);
+
+        std::vector<double> perOp;
+        for (int i = 0; i < this->options.samples; i++) {
+            perOp.push_back(this->_time(f, iterations) / iterations);
+        }
+        std::sort(perOp.begin(), perOp.end());
+
+        BenchResult result;
+        result.name = name;
+        result.nsPerOp = perOp[perOp.size() / 2];
+        result.iterations = iterations * this->options.samples;
+        result.bytes = bytes;
+
+#ifdef RSALITE_COUNTERS
+        RSALite::resetCounters();
+        f();
+        result.counters = RSALite::counters();
+        result.hasCounters = true;
+#endif
+        this->results.push_back(result);
+
+        if (bytes > 0) std::printf("%-28s %14.1f ns/op %10.1f MB/s\n", name.c_str(), result.nsPerOp, bytes * 1e3 / result.nsPerOp);
+        else std::printf("%-28s %14.1f ns/op\n", name.c_str(), result.nsPerOp);
+        std::fflush(stdout);
+    }
+
+    // f(lane) runs on `threads` threads at once for a sample; the result is
+    // the wall time per op on one thread, so a flat series means linear scaling
+    template<typename F>
+    void runThreads(const std::string& name, int threads, F f) {
+        if (!this->options.filter.empty() && name.find(this->options.filter) == std::string::npos) return;
+
+        std::vector<BenchLane> lanes(threads);
+        std::vector<std::thread> workers;
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false), stop(false);
+
+        for (int i = 0; i < threads; i++) {
+            workers.push_back(std::thread([&f, &lanes, &ready, &go, &stop, i]() {
+                BenchLane& lane = lanes[i];
+                f(lane);        // warm-up, not counted
+                ready++;
+                while (!go.load()) std::this_thread::yield();
+                do {
+                    f(lane);
+                    lane.ops++;
+                } while (!stop.load(std::memory_order_relaxed));
+            }));
+        }
+
+        while (ready.load() < threads) std::this_thread::yield();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        go = true;
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(this->options.minMillis * this->options.samples));
+        stop = true;
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        unsigned long long ops = 0;
+        for (size_t i = 0; i < lanes.size(); i++) ops += lanes[i].ops;
+
+        BenchResult result;
+        result.name = name;
+        result.nsPerOp = elapsed * threads / ops;
+        result.iterations = ops;
+        this->results.push_back(result);
+
+        std::printf("%-28s %14.1f ns/op %10.0f ops/s total\n", name.c_str(), result.nsPerOp, ops * 1e9 / elapsed);
+        std::fflush(stdout);
+    }
+
+private:
+    template<typename F>
+    double _time(F& f, unsigned long long iterations) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < iterations; i++) f();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+static std::string _jsonEscape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') out += '\\';
+        out += s[i];
+    }
+    return out;
+}
+
+static void _writeJSON(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path.c_str());
+    if (!out) throw std::invalid_argument("can't write " + path);
+
+    out << "{\n  \"format\": \"rsalite-bench\",\n  \"version\": 1,\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        char ns[64];
+        std::snprintf(ns, sizeof(ns), "%.3f", results[i].nsPerOp);
+
+        out << "    { \"name\": \"" << _jsonEscape(results[i].name) << "\", \"ns_per_op\": " << ns
+            << ", \"iterations\": " << results[i].iterations << ", \"bytes\": " << results[i].bytes;
+
+        if (results[i].hasCounters) {
+            for (int f = 0; f < COUNTER_FIELDS; f++) out << ", \"" << COUNTERS[f].name << "\": " << results[i].counters.*COUNTERS[f].field;
+        }
+
+        out << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads back the files _writeJSON produces: name, ns_per_op and any counters
+static std::vector<BenchResult> _readJSON(const std::string& path) {
+    std::ifstream in(path.c_str());
+    if (!in) throw std::invalid_argument("can't read baseline " + path);
+
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    std::vector<BenchResult> results;
+    size_t pos = 0;
+    while ((pos = text.find("\"name\": \"", pos)) != std::string::npos) {
+        pos += 9;
+        BenchResult result;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\') pos++;
+            result.name += text[pos++];
+        }
+
+        size_t ns = text.find("\"ns_per_op\": ", pos);
+        if (ns == std::string::npos) break;
+        result.nsPerOp = std::strtod(text.c_str() + ns + 13, NULL);
+
+        size_t end = text.find('}', ns);
+        std::string object = text.substr(ns, end == std::string::npos ? std::string::npos : end - ns);
+        for (int f = 0; f < COUNTER_FIELDS; f++) {
+            std::string key = std::string("\"") + COUNTERS[f].name + "\": ";
+            size_t at = object.find(key);
+            if (at == std::string::npos) continue;
+            result.counters.*COUNTERS[f].field = std::strtoull(object.c_str() + at + key.size(), NULL, 10);
+            result.hasCounters = true;
+        }
+
+        results.push_back(result);
+        pos = ns;
+    }
+
+    return results;
+}
+
+static int _compare(const std::vector<BenchResult>& current, const std::vector<BenchResult>& baseline, double threshold) {
+    int regressions = 0;
+
+    std::printf("\n%-28s %14s %14s %9s\n", "benchmark", "baseline", "current", "change");
+    for (size_t i = 0; i < current.size(); i++) {
+        const BenchResult* base = NULL;
+        for (size_t j = 0; j < baseline.size(); j++) {
+            if (baseline[j].name == current[i].name) base = &baseline[j];
+        }
+        if (base == NULL || base->nsPerOp <= 0) {
+            std::printf("%-28s %14s %14.1f %9s\n", current[i].name.c_str(), "-", current[i].nsPerOp, "new");
+            continue;
+        }
+
+        double change = (current[i].nsPerOp / base->nsPerOp - 1) * 100;
+        bool regressed = change > threshold;
+        if (regressed) regressions++;
+
+        std::printf("%-28s %14.1f %14.1f %+8.1f%%%s\n", current[i].name.c_str(), base->nsPerOp, current[i].nsPerOp, change, regressed ? "  REGRESSION" : "");
+
+        if (!current[i].hasCounters || !base->hasCounters) continue;
+
+        for (int f = 0; f < COUNTER_FIELDS; f++) {
+            uint64_t now = current[i].counters.*COUNTERS[f].field;
+            uint64_t then = base->counters.*COUNTERS[f].field;
+            if (now <= then) continue;
+
+            regressions++;
+            std::printf("    %-24s %14llu %14llu  COUNT REGRESSION\n", COUNTERS[f].name, (unsigned long long)then, (unsigned long long)now);
+        }
+    }
+
+    std::printf("\n%d regression(s) over %.1f%%\n", regressions, threshold);
+    return regressions;
+}
+
+static void _benchBigInteger(Bench& bench, int bits, const char* pem) {
+    std::string keyPEM = pem;
+    std::string suffix = "/" + std::to_string(bits);
+
+    bench.run("pem_load" + suffix, 0, [&keyPEM]() {
+        RSAKey key(keyPEM);
+        benchSink = key.e;
+    });
+
+    RSAKey key(keyPEM);
+    BigInteger& n = *key.n;
+    BigInteger& d = *key.d;
+
+    bench.run("multiplyTo" + suffix, 0, [&n, &d]() {
+        BigInteger r;
+        n.multiplyTo(d, r);
+        benchSink = r.t;
+    });
+
+    bench.run("squareTo" + suffix, 0, [&n]() {
+        BigInteger r;
+        n.squareTo(r);
+        benchSink = r.t;
+    });
+
+    BigInteger product;
+    n.multiplyTo(d, product);
+    bench.run("divRemTo" + suffix, 0, [&product, &n]() {
+        BigInteger r;
+        product.divRemTo(n, r);
+        benchSink = r.t;
+    });
+
+    // reduce works in place, so each op also copies its 2n-limb input
+    Montgomery mont(&n);
+    BigInteger dd;
+    d.squareTo(dd);
+    bench.run("montgomery_reduce" + suffix, 0, [&dd, &mont]() {
+        BigInteger x;
+        dd.copyTo(x);
+        mont.reduce(x);
+        benchSink = x.t;
+    });
+
+    // full-size private exponent, no CRT
+    BigInteger* message = n.subtract(d);
+    bench.run("modPow" + suffix, 0, [message, &d, &n]() {
+        BigInteger* r = message->modPow(d, n);
+        benchSink = r->t;
+        delete(r);
+    });
+    delete(message);
+
+    std::string header = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
+    std::string payload = "{\"sub\":\"1234567890\",\"name\":\"John Doe\",\"iat\":1516239022}";
+    bench.run("createJWT_RS256" + suffix, 0, [&header, &payload, &key]() {
+        benchSink = (unsigned int)RSALite::createJWT(header, payload, key).size();
+    });
+
+    // a re-mint of the same claims once the token is cached
+    TokenCache cache;
+    cache.createJWT("bench", header, payload, key);
+    bench.run("tokenCache_hit_RS256" + suffix, 0, [&cache, &header, &payload, &key]() {
+        benchSink = (unsigned int)cache.createJWT("bench", header, payload, key).size();
+    });
+}
+
+// The CRT halves of a fixed-width key, one after the other and interleaved
+template<int Bits>
+static void _benchFixedBigInt(Bench& bench, int keyBits, const char* pem) {
+    typedef FixedBigInt<Bits> F;
+    std::string keyPEM = pem;
+    std::string suffix = "/" + std::to_string(keyBits);
+    RSAKey key(keyPEM);
+    unsigned char bytes[Bits / 8];
+
+    typename F::Modulus P, Q;
+    typename F::Int v, dp, dq, xp, xq;
+    key.p->toBytes(bytes, sizeof(bytes));
+    F::fromBytes(v, bytes, sizeof(bytes));
+    F::initModulus(P, v);
+    key.q->toBytes(bytes, sizeof(bytes));
+    F::fromBytes(v, bytes, sizeof(bytes));
+    F::initModulus(Q, v);
+    key.dmp1->toBytes(bytes, sizeof(bytes));
+    F::fromBytes(dp, bytes, sizeof(bytes));
+    key.dmq1->toBytes(bytes, sizeof(bytes));
+    F::fromBytes(dq, bytes, sizeof(bytes));
+
+    // any base below the moduli will do
+    F::sub(xp, P.m, dp);
+    F::sub(xq, Q.m, dq);
+
+    bench.run("modPow_pq" + suffix, 0, [&]() {
+        typename F::Int rp, rq;
+        F::modPow(rp, xp, dp, P);
+        F::modPow(rq, xq, dq, Q);
+        benchSink = rp[0] ^ rq[0];
+    });
+
+    bench.run("modPow2_pq" + suffix, 0, [&]() {
+        typename F::Int rp, rq;
+        F::modPow2(rp, xp, dp, P, rq, xq, dq, Q);
+        benchSink = rp[0] ^ rq[0];
+    });
+}
+
+// RS256 over the same modulus size split into 2, 3 and 4 primes
+static void _benchMultiPrime(Bench& bench, int bits, const char* pem2, const char* pem3, const char* pem4) {
+    const char* pems[3] = { pem2, pem3, pem4 };
+    std::string header = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
+    std::string payload = "{\"sub\":\"1234567890\",\"name\":\"John Doe\",\"iat\":1516239022}";
+
+    for (int i = 0; i < 3; i++) {
+        std::string keyPEM = pems[i];
+        RSAKey key(keyPEM);
+
+        bench.run("createJWT_RS256/" + std::to_string(bits) + "/" + std::to_string(i + 2) + "p", 0, [&header, &payload, &key]() {
+            benchSink = (unsigned int)RSALite::createJWT(header, payload, key).size();
+        });
+    }
+}
+
+// verifyJWT on one thread, then verifyJWTs over a batch of 256 tokens with a
+// thread per core; divide the batch entry by 256 for ns per token
+static void _benchVerify(Bench& bench, int bits, const char* pem) {
+    std::string keyPEM = pem;
+    RSAKey key(keyPEM);
+    RSAPublicKey publicKey(key);
+    std::string jwt = RSALite::createJWT("{\"alg\":\"RS256\",\"typ\":\"JWT\"}", "{\"sub\":\"1234567890\",\"iat\":1516239022}", key);
+
+    bench.run("verifyJWT_RS256/" + std::to_string(bits), 0, [&jwt, &publicKey]() {
+        benchSink = RSALite::verifyJWT(jwt, publicKey) ? 1 : 0;
+    });
+
+    std::vector<std::string> batch(256, jwt);
+    std::vector<char> valid;
+    bench.run("verifyJWTs_RS256/" + std::to_string(bits), 0, [&batch, &publicKey, &valid]() {
+        benchSink = (unsigned int)RSALite::verifyJWTs(batch, publicKey, valid) / 256;
+    });
+}
+
+// RSAKey::generate with a thread per core; keys/s is 1e9 / ns/op. The time
+// per key swings with where the random starts fall, so raise --samples
+static void _benchKeyGen(Bench& bench, int bits) {
+    bench.run("generate/" + std::to_string(bits), 0, [bits]() {
+        RSAKey* key = RSAKey::generate(bits);
+        benchSink = (unsigned int)key->n->bitLength();
+        delete(key);
+    });
+}
+
+static void _benchDigest(Bench& bench, bool quick) {
+    const size_t shaSizes[] = { 64, 1024, 16384 };
+    const size_t b64Sizes[] = { 48, 256, 4096 };
+
+    for (size_t size : shaSizes) {
+        std::vector<unsigned char> data(size, 0x5a);
+        bench.run("sha256/" + std::to_string(size), size, [&data]() {
+            SHA256 sha;
+            unsigned char digest[32];
+            sha.update(data.data(), data.size());
+            sha.final(digest);
+            benchSink = digest[0];
+        });
+        if (quick) break;
+    }
+
+    for (size_t size : b64Sizes) {
+        std::string data(size, 'x');
+        bench.run("base64url/" + std::to_string(size), size, [&data]() {
+            benchSink = (unsigned int)Digest::urlsafeB64Encode(data).size();
+        });
+        if (quick) break;
+    }
+
+    // encoding and hashing a typical claims set from scratch vs. patching iat / exp
+    std::string header = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
+    ClaimsBuilder claims;
+    claims.add("iss", "https://auth.example.com/tenants/0123456789").add("aud", "https://api.example.com").add("sub", "billing");
+    ClaimsBuilder::Slot iat = claims.addSlot("iat");
+    ClaimsBuilder::Slot exp = claims.addSlot("exp");
+    unsigned long long now = 1700000000ULL;
+
+    bench.run("signingInput_fresh", 0, [&header, &claims]() {
+        SHA256 sha;
+        unsigned char hash[32];
+        std::string input = Digest::urlsafeB64Encode(header) + "." + Digest::urlsafeB64Encode(claims.json());
+        sha.update(input.data(), input.size());
+        sha.final(hash);
+        benchSink = hash[0];
+    });
+    bench.run("signingInput_patched", 0, [&header, &claims, iat, exp, &now]() {
+        unsigned char hash[32];
+        now++;
+        claims.set(iat, now);
+        claims.set(exp, now + 300);
+        claims.signingInput(header, hash);
+        benchSink = hash[0];
+    });
+}
+
+static void _benchOtherAlgorithms(Bench& bench) {
+    std::string payload = "{\"sub\":\"1234567890\",\"name\":\"John Doe\",\"iat\":1516239022}";
+
+    std::string ecPEM = BENCH_KEY_P256;
+    ECKey ecKey(ecPEM);
+    std::string es256 = "{\"alg\":\"ES256\",\"typ\":\"JWT\"}";
+    bench.run("createJWT_ES256", 0, [&es256, &payload, &ecKey]() {
+        benchSink = (unsigned int)RSALite::createJWT(es256, payload, ecKey).size();
+    });
+
+    std::string edPEM = BENCH_KEY_ED25519;
+    Ed25519Key edKey(edPEM);
+    std::string eddsa = "{\"alg\":\"EdDSA\",\"typ\":\"JWT\"}";
+    bench.run("createJWT_EdDSA", 0, [&eddsa, &payload, &edKey]() {
+        benchSink = (unsigned int)RSALite::createJWT(eddsa, payload, edKey).size();
+    });
+
+    HMACSHA256 hmacKey(std::string("bench-shared-secret"));
+    std::string hs256 = "{\"alg\":\"HS256\",\"typ\":\"JWT\"}";
+    bench.run("createJWT_HS256", 0, [&hs256, &payload, &hmacKey]() {
+        benchSink = (unsigned int)RSALite::createJWT(hs256, payload, hmacKey).size();
+    });
+
+#ifdef RSALITE_HAS_STRING_VIEW
+    char out[512];
+    bench.run("createJWT_HS256_buffer", 0, [&hs256, &payload, &hmacKey, &out]() {
+        benchSink = (unsigned int)RSALite::createJWT(hs256, payload, hmacKey, out, sizeof(out));
+    });
+#endif
+}
+
+// createJWT from 1, 2, 4 ... maxThreads threads sharing one prepared key, each
+// into its own buffer; ns/op per thread stays flat while there are free cores
+static void _benchScaling(Bench& bench, int maxThreads) {
+    std::string pem = BENCH_KEY_2048;
+    RSAKey key(pem);
+    key.prepare();
+    HMACSHA256 hmacKey(std::string("bench-shared-secret"));
+
+    std::string header = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
+    std::string payload = "{\"sub\":\"1234567890\",\"name\":\"John Doe\",\"iat\":1516239022}";
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        bench.runThreads("threads_RS256/" + std::to_string(threads), threads, [&header, &payload, &key](BenchLane& lane) {
+#ifdef RSALITE_HAS_STRING_VIEW
+            RSALite::createJWT(header, payload, key, lane.out, sizeof(lane.out));
+#else
+            RSALite::createJWT(header, payload, key).copy(lane.out, sizeof(lane.out));
+#endif
+        });
+    }
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        bench.runThreads("threads_HS256/" + std::to_string(threads), threads, [&header, &payload, &hmacKey](BenchLane& lane) {
+#ifdef RSALITE_HAS_STRING_VIEW
+            RSALite::createJWT(header, payload, hmacKey, lane.out, sizeof(lane.out));
+#else
+            RSALite::createJWT(header, payload, hmacKey).copy(lane.out, sizeof(lane.out));
+#endif
+        });
+    }
+}
+
+static void _usage() {
+    std::fprintf(stderr, "usage: rsalite_bench [--quick] [--filter text] [--min-ms n] [--samples n]\n"
+        "                     [--json out.json] [--baseline base.json] [--threshold pct]\n"
+        "                     [--max-threads n]\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--quick") options.quick = true;
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-ms" && hasValue) options.minMillis = std::atof(argv[++i]);
+        else if (arg == "--samples" && hasValue) options.samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) options.baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) options.threshold = std::atof(argv[++i]);
+        else if (arg == "--max-threads" && hasValue) options.maxThreads = std::max(1, std::atoi(argv[++i]));
+        else {
+            _usage();
+            return 2;
+        }
+    }
+
+    // smoke run: every code path once or twice, smallest key only
+    if (options.quick) {
+        options.minMillis = 0;
+        options.samples = 1;
+        options.maxThreads = std::min(options.maxThreads, 2);
+    }
+
+    try {
+        Bench bench(options);
+
+        _benchDigest(bench, options.quick);
+        _benchBigInteger(bench, 1024, BENCH_KEY_1024);
+        _benchVerify(bench, 1024, BENCH_KEY_1024);
+        if (!options.quick) {
+            _benchBigInteger(bench, 2048, BENCH_KEY_2048);
+            _benchBigInteger(bench, 3072, BENCH_KEY_3072);
+            _benchBigInteger(bench, 4096, BENCH_KEY_4096);
+            _benchFixedBigInt<1024>(bench, 2048, BENCH_KEY_2048);
+            _benchFixedBigInt<1536>(bench, 3072, BENCH_KEY_3072);
+            _benchFixedBigInt<2048>(bench, 4096, BENCH_KEY_4096);
+            _benchMultiPrime(bench, 3072, BENCH_KEY_3072, BENCH_KEY_3072_3P, BENCH_KEY_3072_4P);
+            _benchMultiPrime(bench, 4096, BENCH_KEY_4096, BENCH_KEY_4096_3P, BENCH_KEY_4096_4P);
+            _benchVerify(bench, 2048, BENCH_KEY_2048);
+            _benchVerify(bench, 4096, BENCH_KEY_4096);
+            _benchKeyGen(bench, 2048);
+            _benchKeyGen(bench, 3072);
+            _benchKeyGen(bench, 4096);
+        }
+        else {
+            _benchKeyGen(bench, 1024);
+        }
+        _benchOtherAlgorithms(bench);
+        _benchScaling(bench, options.maxThreads);
+
+        if (!options.jsonPath.empty()) _writeJSON(options.jsonPath, bench.results);
+
+        if (!options.baselinePath.empty()) {
+            std::vector<BenchResult> baseline = _readJSON(options.baselinePath);
+            return _compare(bench.results, baseline, options.threshold) == 0 ? 0 : 1;
+        }
+    }
+    catch (std::exception& e) {
+        std::fprintf(stderr, "rsalite_bench: %s\n", e.what());
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include "../RSALite.h"
+#include "../ClaimsBuilder.h"
+#include "../SigningQueue.h"
+#include "BenchKeys.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Drives RS256 signing the way a service does: N threads for a fixed time,
+// either closed-loop (each thread signs again as soon as it is done) or at a
+// target total rate. At a target rate every request has a scheduled start
+// and its latency counts from there, so a stall also charges the requests
+// that queued up behind it.
+
+typedef std::chrono::steady_clock Clock;
+
+enum LoadApi { API_STRING, API_BUFFER, API_CLAIMS, API_QUEUE };
+
+struct LoadOptions
+{
+    LoadApi api = API_STRING;
+    std::string apiName = "string";
+    int threads = 0;                // 0 for one per core
+    int signers = 0;                // SigningQueue threads for --api queue, 0 for one per core
+    double seconds = 10;
+    double warmupSeconds = 1;
+    double rate = 0;                // total requests per second, 0 for closed loop
+    std::vector<int> keyBits = { 2048 };
+    int keys = 1;
+    bool cold = false;
+    std::string payload = "fixed:256";
+    std::string jsonPath;
+};
+
+// One thread's view of the run; merged when every thread is done
+struct LoadLane
+{
+    RSALiteStageStats latency;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+
+    LoadLane() {
+        latency.buckets.assign(RSALiteHistogram::BUCKETS, 0);
+    }
+
+    void record(uint64_t nanos) {
+        this->latency.count++;
+        this->latency.sumNanos += nanos;
+        this->latency.maxNanos = std::max(this->latency.maxNanos, nanos);
+        this->latency.buckets[RSALiteHistogram::bucketIndex(nanos)]++;
+    }
+
+    void merge(const LoadLane& other) {
+        this->latency.count += other.latency.count;
+        this->latency.sumNanos += other.latency.sumNanos;
+        this->latency.maxNanos = std::max(this->latency.maxNanos, other.latency.maxNanos);
+        for (size_t i = 0; i < this->latency.buckets.size(); i++) this->latency.buckets[i] += other.latency.buckets[i];
+        this->errors += other.errors;
+        this->bytes += other.bytes;
+    }
+};
+
+static const char* _benchKey(int bits) {
+    switch (bits) {
+    case 1024: return BENCH_KEY_1024;
+    case 2048: return BENCH_KEY_2048;
+    case 3072: return BENCH_KEY_3072;
+    case 4096: return BENCH_KEY_4096;
+    }
+    throw std::invalid_argument("no bench key of " + std::to_string(bits) + " bits");
+}
+
+static uint32_t _xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// "fixed:N", "uniform:A-B" or "exp:MEAN" payload sizes in bytes; a pool of
+// claim sets is drawn once, each padded with a filler claim to its size
+static std::vector<std::string> _payloads(const std::string& spec, size_t count) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string args = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    std::vector<std::string> pool;
+    uint32_t state = 0x9e3779b9;
+    for (size_t i = 0; i < count; i++) {
+        double size;
+        if (kind == "fixed") size = std::atof(args.c_str());
+        else if (kind == "uniform") {
+            size_t dash = args.find('-');
+            if (dash == std::string::npos) throw std::invalid_argument("uniform payload wants A-B");
+            double lo = std::atof(args.substr(0, dash).c_str()), hi = std::atof(args.substr(dash + 1).c_str());
+            size = lo + (hi - lo) * (_xorshift(state) / 4294967296.0);
+        }
+        else if (kind == "exp") size = -std::atof(args.c_str()) * std::log(1 - _xorshift(state) / 4294967296.0);
+        else throw std::invalid_argument("unknown payload distribution " + kind);
+
+        std::string payload = "{\"sub\":\"user-" + std::to_string(i) + "\",\"iat\":1516239022,\"pad\":\"";
+        size_t target = (size_t)std::max(0.0, size);
+        if (target > payload.size() + 2) payload.append(target - payload.size() - 2, 'x');
+        payload += "\"}";
+        pool.push_back(payload);
+    }
+    return pool;
+}
+
+static std::vector<int> _intList(const std::string& s) {
+    std::vector<int> values;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+class LoadGenerator
+{
+public:
+    LoadOptions options;
+    std::vector<std::unique_ptr<RSAKey> > keys;
+    std::vector<std::string> pems;          // pems[i] is the source of keys[i]
+    std::vector<std::string> payloads;
+    std::unique_ptr<SigningQueue> queue;
+    std::string header = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
+
+    LoadGenerator(const LoadOptions& options) : options(options) {
+        this->payloads = _payloads(options.payload, 256);
+
+        // the same few PEMs parsed into as many separate keys as asked for, so
+        // a large key set spreads the precomputation over that much memory
+        for (int i = 0; i < options.keys; i++) {
+            std::string pem = _benchKey(options.keyBits[i % options.keyBits.size()]);
+            this->pems.push_back(pem);
+            if (!options.cold) {
+                this->keys.push_back(std::unique_ptr<RSAKey>(new RSAKey(pem)));
+                this->keys.back()->prepare();
+            }
+        }
+
+        if (options.api == API_QUEUE) this->queue.reset(new SigningQueue(options.signers, 4 * options.threads));
+    }
+
+    // runs every thread for the warm-up and the measured time, returns the merged lanes
+    LoadLane run(double& elapsedSeconds) {
+        std::vector<LoadLane> lanes(this->options.threads);
+        std::vector<std::thread> workers;
+        std::atomic<bool> stop(false);
+
+        Clock::time_point start = Clock::now();
+        Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(this->options.warmupSeconds));
+        Clock::time_point end = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(this->options.seconds));
+
+        for (int i = 0; i < this->options.threads; i++) {
+            workers.push_back(std::thread([this, &lanes, &stop, i, start, measureFrom, end]() {
+                this->_worker(lanes[i], i, start, measureFrom, end, stop);
+            }));
+        }
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        elapsedSeconds = std::chrono::duration<double>(std::min(Clock::now(), end) - measureFrom).count();
+
+        LoadLane total;
+        for (size_t i = 0; i < lanes.size(); i++) total.merge(lanes[i]);
+        return total;
+    }
+
+private:
+    void _worker(LoadLane& lane, int index, Clock::time_point start, Clock::time_point measureFrom, Clock::time_point end, std::atomic<bool>& stop) {
+        uint32_t state = 2463534242u + 7919u * (uint32_t)index;
+        std::vector<char> out(1024);
+        ClaimsBuilder claims;
+        ClaimsBuilder::Slot iat;
+        const std::string* built = NULL;
+
+        // requests from the threads interleave evenly at a target rate
+        Clock::duration interval = Clock::duration::zero();
+        Clock::time_point next = start;
+        if (this->options.rate > 0) {
+            interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(this->options.threads / this->options.rate));
+            next = start + interval * index / this->options.threads;
+        }
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (this->options.rate > 0) {
+                std::this_thread::sleep_until(next);
+            }
+            Clock::time_point began = this->options.rate > 0 ? next : Clock::now();
+            if (began >= end) break;
+
+            size_t k = _xorshift(state) % this->pems.size();
+            const std::string& payload = this->payloads[_xorshift(state) % this->payloads.size()];
+            size_t length = 0;
+
+            try {
+                std::unique_ptr<RSAKey> coldKey;
+                if (this->options.cold) coldKey.reset(new RSAKey(this->pems[k]));
+                RSAKey& key = this->options.cold ? *coldKey : *this->keys[k];
+
+                switch (this->options.api) {
+                case API_STRING:
+                    length = RSALite::createJWT(this->header, payload, key).size();
+                    break;
+                case API_BUFFER:
+#ifdef RSALITE_HAS_STRING_VIEW
+                    length = RSALite::createJWT(this->header, payload, key, out.data(), out.size());
+                    if (length > out.size()) {
+                        out.resize(length);
+                        length = RSALite::createJWT(this->header, payload, key, out.data(), out.size());
+                    }
+#else
+                    length = RSALite::createJWT(this->header, payload, key).copy(out.data(), out.size());
+#endif
+                    break;
+                case API_CLAIMS:
+                    // rebuilt only when the drawn payload changes; iat moves every time
+                    if (built != &payload) {
+                        claims.clear();
+                        claims.addJSON("claims", payload);
+                        iat = claims.addSlot("iat");
+                        built = &payload;
+                    }
+                    claims.set(iat, (unsigned long long)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+                    length = RSALite::createJWT(this->header, claims, key).size();
+                    break;
+                case API_QUEUE:
+                    length = this->queue->submit(this->header, payload, key).get().size();
+                    break;
+                }
+            }
+            catch (std::exception&) {
+                if (began >= measureFrom) lane.errors++;
+            }
+
+            Clock::time_point done = Clock::now();
+            if (began >= measureFrom && done <= end) {
+                lane.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(done - began).count());
+                lane.bytes += length;
+            }
+            if (done >= end) stop = true;
+            next += interval;
+        }
+    }
+};
+
+static std::string _jsonEscape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') out += '\\';
+        out += s[i];
+    }
+    return out;
+}
+
+static const double PERCENTILES[] = { 50, 90, 99, 99.9 };
+static const char* PERCENTILE_NAMES[] = { "p50", "p90", "p99", "p99_9" };
+
+static void _report(const LoadOptions& options, const LoadLane& total, double seconds) {
+    std::string bits;
+    for (size_t i = 0; i < options.keyBits.size(); i++) bits += (i > 0 ? "," : "") + std::to_string(options.keyBits[i]);
+    double throughput = seconds > 0 ? total.latency.count / seconds : 0;
+
+    std::printf("api %s, RS256/%s, %d keys (%s), payload %s, %d threads, %s\n",
+        options.apiName.c_str(), bits.c_str(), options.keys, options.cold ? "cold" : "warm", options.payload.c_str(), options.threads,
+        options.rate > 0 ? ("target " + std::to_string((long long)options.rate) + " req/s").c_str() : "closed loop");
+    std::printf("%-12s %12llu\n", "requests", (unsigned long long)total.latency.count);
+    std::printf("%-12s %12llu\n", "errors", (unsigned long long)total.errors);
+    std::printf("%-12s %12.1f req/s\n", "throughput", throughput);
+    std::printf("%-12s %12.1f us\n", "mean", total.latency.meanNanos() / 1e3);
+    for (int i = 0; i < 4; i++) std::printf("%-12s %12.1f us\n", PERCENTILE_NAMES[i], total.latency.percentile(PERCENTILES[i]) / 1e3);
+    std::printf("%-12s %12.1f us\n", "max", total.latency.maxNanos / 1e3);
+
+    if (options.jsonPath.empty()) return;
+
+    std::ofstream out(options.jsonPath.c_str());
+    if (!out) throw std::invalid_argument("can't write " + options.jsonPath);
+
+    out << "{\n  \"format\": \"rsalite-loadgen\",\n  \"version\": 1,\n"
+        << "  \"api\": \"" << _jsonEscape(options.apiName) << "\",\n"
+        << "  \"key_bits\": [" << bits << "],\n"
+        << "  \"keys\": " << options.keys << ",\n"
+        << "  \"cold\": " << (options.cold ? "true" : "false") << ",\n"
+        << "  \"payload\": \"" << _jsonEscape(options.payload) << "\",\n"
+        << "  \"threads\": " << options.threads << ",\n"
+        << "  \"target_rate\": " << options.rate << ",\n"
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"requests\": " << total.latency.count << ",\n"
+        << "  \"errors\": " << total.errors << ",\n"
+        << "  \"bytes\": " << total.bytes << ",\n"
+        << "  \"throughput\": " << throughput << ",\n"
+        << "  \"latency_ns\": { \"mean\": " << (uint64_t)total.latency.meanNanos();
+    for (int i = 0; i < 4; i++) out << ", \"" << PERCENTILE_NAMES[i] << "\": " << total.latency.percentile(PERCENTILES[i]);
+    out << ", \"max\": " << total.latency.maxNanos << " }\n}\n";
+}
+
+static void _usage() {
+    std::fprintf(stderr, "usage: rsalite_loadgen [--api string|buffer|claims|queue] [--threads n] [--signers n]\n"
+        "                       [--seconds s] [--warmup s] [--rate req/s] [--key-bits 2048[,4096...]]\n"
+        "                       [--keys n] [--cold] [--payload fixed:N|uniform:A-B|exp:MEAN] [--json out.json]\n");
+}
+
+int main(int argc, char** argv) {
+    LoadOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--api" && hasValue) options.apiName = argv[++i];
+        else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (arg == "--signers" && hasValue) options.signers = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue) options.seconds = std::atof(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmupSeconds = std::atof(argv[++i]);
+        else if (arg == "--rate" && hasValue) options.rate = std::atof(argv[++i]);
+        else if (arg == "--key-bits" && hasValue) options.keyBits = _intList(argv[++i]);
+        else if (arg == "--keys" && hasValue) options.keys = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--cold") options.cold = true;
+        else if (arg == "--payload" && hasValue) options.payload = argv[++i];
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else {
+            _usage();
+            return 2;
+        }
+    }
+
+    if (options.apiName == "string") options.api = API_STRING;
+    else if (options.apiName == "buffer") options.api = API_BUFFER;
+    else if (options.apiName == "claims") options.api = API_CLAIMS;
+    else if (options.apiName == "queue") options.api = API_QUEUE;
+    else {
+        _usage();
+        return 2;
+    }
+
+    int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    if (options.threads <= 0) options.threads = cores;
+    if (options.signers <= 0) options.signers = cores;
+    if (options.keyBits.empty()) options.keyBits.push_back(2048);
+
+    try {
+        LoadGenerator generator(options);
+        double seconds = 0;
+        LoadLane total = generator.run(seconds);
+        _report(options, total, seconds);
+
+        return total.errors == 0 ? 0 : 1;
+    }
+    catch (std::exception& e) {
+        std::fprintf(stderr, "rsalite_loadgen: %s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../ClaimsBuilder.h"
+#include "TestKeys.h"
+#include <cstring>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ClaimsBuilderTest
+{
+	static void _expectInput(ClaimsBuilder& claims, const std::string& header) {
+		unsigned char hash[32], expected[32];
+		std::string input = Digest::urlsafeB64Encode(header) + "." + Digest::urlsafeB64Encode(claims.json());
+
+		SHA256 sha;
+		sha.update(input.data(), input.size());
+		sha.final(expected);
+
+		Assert::AreEqual(input, claims.signingInput(header, hash));
+		Assert::IsTrue(std::memcmp(expected, hash, 32) == 0);
+	}
+
+	TEST_CLASS(ClaimsBuilderTest)
+	{
+	public:
+
+		TEST_METHOD(serializesClaims)
+		{
+			ClaimsBuilder claims;
+			Assert::AreEqual(std::string("{}"), claims.json());
+
+			claims.add("sub", "1234567890").add("name", "John Doe").add("admin", true).add("iat", 1516239022LL);
+			Assert::AreEqual(TEST_PAYLOAD, claims.json());
+
+			claims.clear();
+			claims.add("q", std::string("a\"b\\c\n")).addJSON("aud", "[\"x\",\"y\"]");
+			Assert::AreEqual(std::string("{\"q\":\"a\\\"b\\\\c\\u000a\",\"aud\":[\"x\",\"y\"]}"), claims.json());
+		}
+
+		TEST_METHOD(slotsArePaddedInPlace)
+		{
+			ClaimsBuilder claims;
+			ClaimsBuilder::Slot iat = claims.addSlot("iat");
+			claims.add("sub", "svc");
+
+			Assert::AreEqual(std::string("{\"iat\":         0,\"sub\":\"svc\"}"), claims.json());
+
+			claims.set(iat, 1700000000ULL);
+			Assert::AreEqual(std::string("{\"iat\":1700000000,\"sub\":\"svc\"}"), claims.json());
+
+			claims.set(iat, 42);
+			Assert::AreEqual(std::string("{\"iat\":        42,\"sub\":\"svc\"}"), claims.json());
+
+			Assert::ExpectException<std::invalid_argument>([&]() { claims.set(iat, 12345678901ULL); });
+			Assert::ExpectException<std::invalid_argument>([&]() { claims.addSlot("x", 0); });
+		}
+
+		TEST_METHOD(signingInputFollowsPatches)
+		{
+			// enough leading claims that the saved SHA-256 state covers whole blocks
+			ClaimsBuilder claims;
+			claims.add("iss", "https://issuer.example.com/tenants/0123456789abcdef").add("aud", "https://api.example.com/");
+			ClaimsBuilder::Slot iat = claims.addSlot("iat");
+			ClaimsBuilder::Slot exp = claims.addSlot("exp");
+			ClaimsBuilder::Slot jti = claims.addSlot("jti", 20);
+			claims.add("sub", "svc");
+
+			_expectInput(claims, TEST_HEADER);
+
+			for (unsigned long long i = 0; i < 200; i++) {
+				claims.set(iat, 1700000000ULL + i);
+				claims.set(exp, 1700000300ULL + i);
+				claims.set(jti, i * 7919);
+				_expectInput(claims, TEST_HEADER);
+			}
+
+			_expectInput(claims, "{\"alg\":\"HS256\"}");
+
+			claims.add("late", 1LL);
+			_expectInput(claims, "{\"alg\":\"HS256\"}");
+		}
+
+		TEST_METHOD(createJWTMatchesPayloadVariant)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey rsaKey(pem);
+			HMACSHA256 hmacKey(std::string("secret"));
+
+			ClaimsBuilder claims;
+			claims.add("sub", "1234567890").add("name", "John Doe").add("admin", true).add("iat", 1516239022LL);
+			Assert::AreEqual(TEST_JWT_2048, RSALite::createJWT(TEST_HEADER, claims, rsaKey));
+
+			claims.clear();
+			ClaimsBuilder::Slot exp = claims.addSlot("exp");
+			claims.set(exp, 1700000000ULL);
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, claims.json(), hmacKey), RSALite::createJWT(TEST_HEADER, claims, hmacKey));
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, claims.json(), rsaKey), RSALite::createJWT(TEST_HEADER, claims, rsaKey));
+		}
+	};
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../P256.h"
+#include "../Ed25519.h"
+#include "TestKeys.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// Many threads signing with the same key objects at once. Run under
+// ThreadSanitizer (-DRSALITE_SANITIZE=thread) to catch shared state.
+namespace ConcurrencyTest
+{
+	static const int THREADS = 16;
+
+	// Runs fn(thread) on every thread from a common start line
+	template<typename F>
+	static void _race(F fn) {
+		std::atomic<int> ready(0);
+		std::vector<std::thread> threads;
+
+		for (int i = 0; i < THREADS; i++) {
+			threads.push_back(std::thread([&ready, &fn, i]() {
+				ready++;
+				while (ready.load() < THREADS) std::this_thread::yield();
+				fn(i);
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	}
+
+	TEST_CLASS(ConcurrencyTest)
+	{
+	public:
+
+		TEST_METHOD(sharedRSAKeyPreparesOnce)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);	// not prepared: every thread races into prepare()
+			std::vector<std::string> results(THREADS);
+
+			_race([&](int i) {
+				results[i] = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			});
+
+			for (int i = 0; i < THREADS; i++) Assert::AreEqual(TEST_JWT_2048, results[i]);
+		}
+
+		TEST_METHOD(everyAlgorithmFromManyThreads)
+		{
+			std::string rsaPEM = TEST_PRIVATE_KEY_2048, ecPEM = TEST_PRIVATE_KEY_P256, edPEM = TEST_PRIVATE_KEY_ED25519;
+			RSAKey rsaKey(rsaPEM);
+			ECKey ecKey(ecPEM);
+			Ed25519Key edKey(edPEM);
+			HMACSHA256 hmacKey(std::string("secret"));
+			std::vector<std::string> results(4 * THREADS);
+
+			// each thread has its own payload, so a result leaking between threads shows
+			_race([&](int i) {
+				std::string payload = "{\"thread\":" + std::to_string(i) + "}";
+				results[4 * i] = RSALite::createJWT(TEST_HEADER, payload, rsaKey);
+				results[4 * i + 1] = RSALite::createJWT(TEST_HEADER, payload, ecKey);
+				results[4 * i + 2] = RSALite::createJWT(TEST_HEADER, payload, edKey);
+				results[4 * i + 3] = RSALite::createJWT(TEST_HEADER, payload, hmacKey);
+			});
+
+			for (int i = 0; i < THREADS; i++) {
+				std::string payload = "{\"thread\":" + std::to_string(i) + "}";
+				Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, rsaKey), results[4 * i]);
+				Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, ecKey), results[4 * i + 1]);
+				Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, edKey), results[4 * i + 2]);
+				Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, hmacKey), results[4 * i + 3]);
+			}
+		}
+
+		TEST_METHOD(keysLoadedConcurrently)
+		{
+			std::vector<std::string> results(THREADS);
+
+			_race([&](int i) {
+				results[i] = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, TEST_PRIVATE_KEY_2048);
+			});
+
+			for (int i = 0; i < THREADS; i++) Assert::AreEqual(TEST_JWT_2048, results[i]);
+		}
+	};
+}
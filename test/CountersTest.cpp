@@ -0,0 +1,89 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "TestKeys.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace CountersTest
+{
+	// Exact operation counts for one signature in the default profile. A
+	// change here means the arithmetic did more (or less) work; update the
+	// numbers deliberately.
+	TEST_CLASS(CountersTest)
+	{
+	public:
+
+		TEST_METHOD(rs256Counts)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			RSALite::resetCounters();
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			RSALiteCounters c = RSALite::counters();
+
+#if defined(RSALITE_COUNTERS) && !defined(RSALITE_FIXED_LIMBS)
+			// FixedBigInt<1024> halves: no BigInteger and no limb allocation at all
+			Assert::AreEqual((uint64_t)0, c.amIterations);
+			Assert::AreEqual((uint64_t)386, c.multiplyTo);
+			Assert::AreEqual((uint64_t)2054, c.squareTo);
+			Assert::AreEqual((uint64_t)2439, c.reduce);
+			Assert::AreEqual((uint64_t)0, c.divRemTo);
+			Assert::AreEqual((uint64_t)0, c.bigIntegers);
+			Assert::AreEqual((uint64_t)0, c.allocations);
+			Assert::AreEqual((uint64_t)3, c.digestBlocks);
+#elif !defined(RSALITE_COUNTERS)
+			Assert::AreEqual((uint64_t)0, c.multiplyTo);
+#endif
+		}
+
+		// 512-bit primes have no fixed width and take the dynamic BigInteger path
+		TEST_METHOD(rs256DynamicCounts)
+		{
+			std::string pem = TEST_PRIVATE_KEY_1024;
+			RSAKey key(pem);
+
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			RSALite::resetCounters();
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			RSALiteCounters c = RSALite::counters();
+
+#if defined(RSALITE_COUNTERS) && !defined(RSALITE_FIXED_LIMBS)
+			Assert::AreEqual((uint64_t)792580, c.amIterations);
+			Assert::AreEqual((uint64_t)213, c.multiplyTo);
+			Assert::AreEqual((uint64_t)1018, c.squareTo);
+			Assert::AreEqual((uint64_t)1231, c.reduce);
+			Assert::AreEqual((uint64_t)3, c.divRemTo);
+			Assert::AreEqual((uint64_t)65, c.bigIntegers);
+			Assert::AreEqual((uint64_t)3, c.digestBlocks);
+
+			// vector growth differs between standard libraries, so allocations only get a ceiling
+			Assert::IsTrue(c.allocations <= 150);
+			Assert::IsTrue(c.bytesAllocated <= 40000);
+#elif !defined(RSALITE_COUNTERS)
+			Assert::AreEqual((uint64_t)0, c.multiplyTo);
+#endif
+		}
+
+		TEST_METHOD(hs256Counts)
+		{
+			HMACSHA256 key(std::string("secret"));
+
+			RSALite::resetCounters();
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key);
+			RSALiteCounters c = RSALite::counters();
+
+#ifdef RSALITE_COUNTERS
+			// 128-byte signing input: two message blocks and a padding block inside, one block outside
+			Assert::AreEqual((uint64_t)4, c.digestBlocks);
+			Assert::AreEqual((uint64_t)0, c.bigIntegers);
+			Assert::AreEqual((uint64_t)0, c.amIterations);
+#else
+			Assert::AreEqual((uint64_t)0, c.digestBlocks);
+#endif
+		}
+	};
+}
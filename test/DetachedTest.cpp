@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../RSAPublicKey.h"
+#include "TestKeys.h"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace DetachedTest
+{
+	static const std::string UNENCODED_HEADER = "{\"alg\":\"RS256\",\"b64\":false,\"crit\":[\"b64\"]}";
+
+	// spans several read chunks and ends mid-block
+	static std::string _content() {
+		std::string content;
+		for (int i = 0; content.size() < (3u << 20) + 17; i++) content += "line " + std::to_string(i) + " of the artifact\n";
+		return content;
+	}
+
+	static std::string _hashOf(const std::string& data) {
+		SHA256 sha;
+		unsigned char hash[32];
+		sha.update(data.data(), data.size());
+		sha.final(hash);
+		return std::string((const char*)hash, 32);
+	}
+
+	TEST_CLASS(DetachedTest)
+	{
+	public:
+
+		TEST_METHOD(signStreamMatchesHash)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048, content = _content();
+			RSAKey key(pem);
+			std::istringstream in(content);
+
+			std::string signature = RSALite::signStream(in, key);
+			std::string hash = _hashOf(content);
+			RSAPublicKey publicKey(key);
+
+			Assert::AreEqual((size_t)256, signature.size());
+			Assert::IsTrue(publicKey.verify((const unsigned char*)hash.data(), (const unsigned char*)signature.data(), signature.size()));
+		}
+
+		TEST_METHOD(signFileMatchesStream)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048, content = _content();
+			RSAKey key(pem);
+
+			std::string path = "detached_test_artifact.bin";
+			{
+				std::ofstream out(path.c_str(), std::ios::binary);
+				out << content;
+			}
+
+			std::istringstream in(content);
+			std::string fromFile = RSALite::signFile(path, key);
+			std::string jws = RSALite::createDetachedJWS(UNENCODED_HEADER, path, key);
+			std::remove(path.c_str());
+
+			Assert::AreEqual(RSALite::signStream(in, key), fromFile);
+
+			std::istringstream again(content);
+			Assert::AreEqual(RSALite::createDetachedJWS(UNENCODED_HEADER, again, key), jws);
+		}
+
+		TEST_METHOD(detachedJWSSignsUnencodedPayload)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048, content = "{\"artifact\":\"build-42\"}";
+			RSAKey key(pem);
+			std::istringstream in(content);
+
+			std::string jws = RSALite::createDetachedJWS(UNENCODED_HEADER, in, key);
+			std::string encodedHeader = Digest::urlsafeB64Encode(UNENCODED_HEADER);
+
+			// RFC 7797: base64url(header) ".." base64url(signature), the signature over base64url(header) "." payload
+			Assert::AreEqual(encodedHeader + "..", jws.substr(0, encodedHeader.size() + 2));
+
+			std::string hash = _hashOf(encodedHeader + "." + content);
+			std::string signature(key.signatureLength(), '\0');
+			key.sign((const unsigned char*)hash.data(), (unsigned char*)&signature[0]);
+			Assert::AreEqual(encodedHeader + ".." + Digest::urlsafeB64Encode(signature), jws);
+		}
+
+		TEST_METHOD(detachedJWSRejectsEncodedHeader)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			std::istringstream in("payload");
+
+			Assert::ExpectException<std::invalid_argument>([&]() { RSALite::createDetachedJWS(TEST_HEADER, in, key); });
+			Assert::ExpectException<std::invalid_argument>([&]() { RSALite::createDetachedJWS("{\"alg\":\"RS256\",\"b64\":true}", in, key); });
+			Assert::ExpectException<std::invalid_argument>([&]() { RSALite::createDetachedJWS("{\"alg\":\"RS256\",\"b64\":false}", in, key); });
+			Assert::ExpectException<std::invalid_argument>([&]() { RSALite::createDetachedJWS("{\"alg\":\"RS256\",\"b64\":false,\"crit\":[\"exp\"]}", in, key); });
+			Assert::ExpectException<std::invalid_argument>([&]() { RSALite::signFile("detached_test_missing.bin", key); });
+
+			std::istringstream spaced("payload");
+			Assert::IsFalse(RSALite::createDetachedJWS("{\"alg\":\"RS256\", \"b64\" : false, \"crit\":[\"b64\"]}", spaced, key).empty());
+			std::istringstream critFirst("payload");
+			Assert::IsFalse(RSALite::createDetachedJWS("{\"crit\":[\"b64\"],\"alg\":\"RS256\",\"b64\":false}", critFirst, key).empty());
+		}
+	};
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 #include "../RSALite.h"
+#include <cstring>
 #include <string>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -24,6 +25,24 @@ namespace DigestTest
 			Assert::AreEqual("eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiYWRtaW4iOnRydWUsImlhdCI6MTUxNjIzOTAyMn0", encodedPayload.c_str());
 		}
 
+		TEST_METHOD(urlsafeB64EncodeIntoBuffer)
+		{
+			std::string data = "\xfb\xff\xbf" "any carnal pleasure.";
+			char out[64];
+
+			for (size_t len = 0; len <= data.size(); len++) {
+				size_t written = Digest::urlsafeB64Encode(data.data(), len, out);
+				Assert::AreEqual(Digest::urlsafeB64Length(len), written);
+				Assert::AreEqual(Digest::urlsafeB64Encode(data.substr(0, len)), std::string(out, written));
+			}
+
+			// encoding bytes that sit at the tail of the output range
+			size_t total = Digest::urlsafeB64Length(data.size());
+			std::memcpy(out + total - data.size(), data.data(), data.size());
+			Digest::urlsafeB64Encode(out + total - data.size(), data.size(), out);
+			Assert::AreEqual(Digest::urlsafeB64Encode(data), std::string(out, total));
+		}
+
 		TEST_METHOD(digestStringWithSHA256)
 		{
 			std::string in = "eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiYWRtaW4iOnRydWUsImlhdCI6MTUxNjIzOTAyMn0";
@@ -32,6 +51,31 @@ namespace DigestTest
 			Assert::AreEqual("8041fb8cba9e4f8cc1483790b05262841f27fdcb211bc039ddf8864374db5f53", act.c_str());
 		}
 
+		TEST_METHOD(digestUnalignedLengths)
+		{
+			Assert::AreEqual("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", Digest::digestStringWithSHA256("").c_str());
+			Assert::AreEqual("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", Digest::digestStringWithSHA256("abc").c_str());
+			Assert::AreEqual("36bbe50ed96841d10443bcb670d6554f0a34b761be67ec9c4a8ad2c0c44ca42c", Digest::digestStringWithSHA256("abcde").c_str());
+			Assert::AreEqual("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", Digest::digestStringWithSHA256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").c_str());
+		}
+
+		TEST_METHOD(hmacSHA256)
+		{
+			// RFC 4231 test case 6, key longer than a block
+			std::string key(131, '\xaa');
+			std::string data = "Test Using Larger Than Block-Size Key - Hash Key First";
+			unsigned char mac[32];
+
+			HMACSHA256(key).sign(data.data(), data.size(), mac);
+
+			std::string hex;
+			for (int i = 0; i < 32; i++) {
+				hex += "0123456789abcdef"[mac[i] >> 4];
+				hex += "0123456789abcdef"[mac[i] & 0xf];
+			}
+			Assert::AreEqual("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54", hex.c_str());
+		}
+
 		TEST_METHOD(getPaddedDigestInfoHex)
 		{
 			std::string act = Digest::getPaddedDigestInfoHex("8041fb8cba9e4f8cc1483790b05262841f27fdcb211bc039ddf8864374db5f53", 2048);
@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "TestKeys.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#ifdef RSALITE_FIXED_LIMBS
+
+// Counts this thread's heap allocations while armed; the embedded test
+// runner is a separate executable, so replacing operator new is harmless
+static thread_local bool HEAP_ARMED = false;
+static thread_local size_t HEAP_ALLOCATIONS = 0;
+static thread_local size_t HEAP_BYTES = 0;
+
+void* operator new(size_t size) {
+	if (HEAP_ARMED) {
+		HEAP_ALLOCATIONS++;
+		HEAP_BYTES += size;
+	}
+
+	void* p = std::malloc(size > 0 ? size : 1);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace EmbeddedTest
+{
+	static unsigned char ARENA[96 * 1024];
+
+	struct SignJob
+	{
+		RSAKey* key;
+		unsigned char hash[32];
+		unsigned char signature[512];
+		size_t arenaPeak;
+		size_t arenaLeft;
+		size_t heapAllocations;
+		size_t heapBytes;
+	};
+
+	// One warm-up signature fills in the key's precomputation and the
+	// thread's stats block, then a second one is measured
+	static void _sign(SignJob& job) {
+		RSALiteArena arena(ARENA, sizeof(ARENA));
+		RSALiteArenaScope scope(&arena);
+
+		job.key->sign(job.hash, job.signature);
+		arena.resetPeak();
+
+		HEAP_ALLOCATIONS = HEAP_BYTES = 0;
+		HEAP_ARMED = true;
+		job.key->sign(job.hash, job.signature);
+		HEAP_ARMED = false;
+
+		job.heapAllocations = HEAP_ALLOCATIONS;
+		job.heapBytes = HEAP_BYTES;
+		job.arenaPeak = arena.peak();
+		job.arenaLeft = arena.used();
+	}
+
+#ifndef _WIN32
+	static const size_t STACK_SIZE = 256 * 1024;
+	static const unsigned char STACK_PAINT = 0xa5;
+
+	static void* _signThread(void* job) {
+		_sign(*(SignJob*)job);
+		return NULL;
+	}
+
+	static void* _idleThread(void*) {
+		return NULL;
+	}
+
+	// Bytes of a painted stack written by a thread running fn; glibc also
+	// keeps the thread's TLS at the top of a caller-supplied stack
+	static size_t _stackUsed(void* (*fn)(void*), void* arg) {
+		void* stack = NULL;
+		if (posix_memalign(&stack, 4096, STACK_SIZE) != 0) throw std::bad_alloc();
+		std::memset(stack, STACK_PAINT, STACK_SIZE);
+
+		pthread_attr_t attr;
+		pthread_t thread;
+		pthread_attr_init(&attr);
+		pthread_attr_setstack(&attr, stack, STACK_SIZE);
+		pthread_create(&thread, &attr, fn, arg);
+		pthread_join(thread, NULL);
+		pthread_attr_destroy(&attr);
+
+		size_t untouched = 0;
+		while (untouched < STACK_SIZE && ((unsigned char*)stack)[untouched] == STACK_PAINT) untouched++;
+
+		std::free(stack);
+		return STACK_SIZE - untouched;
+	}
+#endif
+
+	// Signs on a fresh thread and returns its stack use beyond an idle thread's;
+	// the first run also pays for lazy symbol binding, so it is repeated
+	static size_t _measure(SignJob& job) {
+#ifndef _WIN32
+		size_t idle = _stackUsed(_idleThread, NULL);
+		_stackUsed(_signThread, &job);
+		size_t used = _stackUsed(_signThread, &job);
+		return used > idle ? used - idle : 0;
+#else
+		_sign(job);
+		return 0;
+#endif
+	}
+
+	static void _check(const std::string& pem, const std::string& expectedJWT, const char* label) {
+		std::string keyPEM = pem;
+		RSAKey key(keyPEM);
+
+		std::string signingInput = expectedJWT.substr(0, expectedJWT.rfind('.'));
+		SignJob job = {};
+		job.key = &key;
+
+		SHA256 sha;
+		sha.update(signingInput.data(), signingInput.size());
+		sha.final(job.hash);
+
+		size_t stack = _measure(job);
+
+		std::string signature((const char*)job.signature, key.signatureLength());
+		Assert::AreEqual(expectedJWT, signingInput + "." + Digest::urlsafeB64Encode(signature));
+
+		char line[160];
+		std::snprintf(line, sizeof(line), "%s: arena peak %zu bytes, stack %zu bytes, heap %zu allocations / %zu bytes",
+			label, job.arenaPeak, stack, job.heapAllocations, job.heapBytes);
+		Logger::WriteMessage(line);
+
+		Assert::AreEqual((size_t)0, job.heapAllocations);
+		Assert::AreEqual((size_t)0, job.arenaLeft);
+		Assert::IsTrue(stack < 16 * 1024);
+
+		// the fixed-width path keeps everything on the stack, the dynamic one in the arena
+		if (key.fixed != NULL) Assert::AreEqual((size_t)0, job.arenaPeak);
+		else Assert::IsTrue(job.arenaPeak > 0);
+	}
+
+	TEST_CLASS(EmbeddedTest)
+	{
+	public:
+
+		TEST_METHOD(rs256In1024Arena)
+		{
+			_check(TEST_PRIVATE_KEY_1024, TEST_JWT_1024, "RS256/1024");
+		}
+
+		TEST_METHOD(rs256In2048Arena)
+		{
+			_check(TEST_PRIVATE_KEY_2048, TEST_JWT_2048, "RS256/2048");
+		}
+
+		TEST_METHOD(rs256In4096Arena)
+		{
+			_check(TEST_PRIVATE_KEY_4096, TEST_JWT_4096, "RS256/4096");
+		}
+
+		TEST_METHOD(createJWTMatchesHeapProfile)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			RSALiteArena arena(ARENA, sizeof(ARENA));
+			RSALiteArenaScope scope(&arena);
+
+			Assert::AreEqual(TEST_JWT_2048, RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key));
+			Assert::AreEqual((size_t)0, arena.used());
+		}
+
+#ifdef RSALITE_HAS_STRING_VIEW
+		TEST_METHOD(createJWTIntoBufferIsHeapFree)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey rsaKey(pem);
+			HMACSHA256 hmacKey(std::string("secret"));
+			std::string hs256 = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, hmacKey);
+			char out[1024];
+			size_t rsLen, hsLen;
+
+			RSALiteArena arena(ARENA, sizeof(ARENA));
+			RSALiteArenaScope scope(&arena);
+			RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, rsaKey, out, sizeof(out));
+
+			HEAP_ALLOCATIONS = HEAP_BYTES = 0;
+			HEAP_ARMED = true;
+			rsLen = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, rsaKey, out, sizeof(out));
+			HEAP_ARMED = false;
+			Assert::AreEqual(TEST_JWT_2048, std::string(out, rsLen));
+
+			HEAP_ARMED = true;
+			hsLen = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, hmacKey, out, sizeof(out));
+			HEAP_ARMED = false;
+			Assert::AreEqual(hs256, std::string(out, hsLen));
+
+			Assert::AreEqual((size_t)0, HEAP_ALLOCATIONS);
+			Assert::AreEqual((size_t)0, arena.used());
+		}
+#endif
+
+		TEST_METHOD(exhaustedArenaThrows)
+		{
+			std::string pem = TEST_PRIVATE_KEY_1024;	// dynamic path
+			RSAKey key(pem);
+			unsigned char hash[32] = {}, signature[128];
+			static unsigned char small[4096];
+
+			key.prepare();
+
+			RSALiteArena arena(small, sizeof(small));
+			RSALiteArenaScope scope(&arena);
+
+			Assert::ExpectException<std::bad_alloc>([&]() { key.sign(hash, signature); });
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../FixedBigInt.h"
+#include "TestKeys.h"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FixedBigIntTest
+{
+	typedef FixedBigInt<1024> F;
+
+	// Deterministic filler bytes (xorshift)
+	static std::vector<unsigned char> _bytes(size_t len, unsigned int seed) {
+		std::vector<unsigned char> out(len);
+		for (size_t i = 0; i < len; i++) {
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			out[i] = (unsigned char)seed;
+		}
+		return out;
+	}
+
+	static std::string _hex(BigInteger* x) {
+		std::string s = x->toString();
+		delete(x);
+		return s;
+	}
+
+	TEST_CLASS(FixedBigIntTest)
+	{
+	public:
+
+		TEST_METHOD(modPowMatchesBigInteger)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			unsigned char bytes[F::LIMBS * 4];
+
+			F::Int m, e, x, r;
+			F::Modulus M;
+			key.p->toBytes(bytes, sizeof(bytes));
+			F::fromBytes(m, bytes, sizeof(bytes));
+			F::initModulus(M, m);
+
+			for (unsigned int seed = 1; seed <= 4; seed++) {
+				std::vector<unsigned char> base = _bytes(sizeof(bytes), seed), exp = _bytes(sizeof(bytes) - seed, seed + 100);
+
+				BigInteger bx, be;
+				bx.fromBytes(base.data(), base.size());
+				be.fromBytes(exp.data(), exp.size());
+				BigInteger* xmod = bx.mod(*key.p);
+
+				F::fromBytes(e, exp.data(), exp.size());
+				xmod->toBytes(bytes, sizeof(bytes));
+				F::fromBytes(x, bytes, sizeof(bytes));
+				F::modPow(r, x, e, M);
+
+				BigInteger fixed;
+				F::toBytes(bytes, sizeof(bytes), r);
+				fixed.fromBytes(bytes, sizeof(bytes));
+
+				Assert::AreEqual(_hex(xmod->modPow(be, *key.p)), fixed.toString());
+				delete(xmod);
+			}
+		}
+
+		TEST_METHOD(modPow2MatchesTwoModPows)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			unsigned char bytes[F::LIMBS * 4];
+
+			F::Int m, x1, x2, e1, e2, r1, r2, s1, s2;
+			F::Modulus P, Q;
+			key.p->toBytes(bytes, sizeof(bytes));
+			F::fromBytes(m, bytes, sizeof(bytes));
+			F::initModulus(P, m);
+			key.q->toBytes(bytes, sizeof(bytes));
+			F::fromBytes(m, bytes, sizeof(bytes));
+			F::initModulus(Q, m);
+
+			// exponents of unequal length, down to an empty one, so the lanes' windows end apart
+			size_t lengths[4][2] = { { 128, 128 }, { 128, 61 }, { 3, 100 }, { 0, 17 } };
+			for (unsigned int i = 0; i < 4; i++) {
+				std::vector<unsigned char> a = _bytes(lengths[i][0], i + 1), b = _bytes(lengths[i][1], i + 50);
+				std::vector<unsigned char> base = _bytes(sizeof(bytes), i + 200);
+				base[0] = 0;	// below both moduli
+
+				F::fromBytes(e1, a.data(), a.size());
+				F::fromBytes(e2, b.data(), b.size());
+				F::fromBytes(x1, base.data(), base.size());
+				F::fromBytes(x2, base.data() + 1, base.size() - 1);
+
+				F::modPow(r1, x1, e1, P);
+				F::modPow(r2, x2, e2, Q);
+				F::modPow2(s1, x1, e1, P, s2, x2, e2, Q);
+
+				Assert::IsTrue(r1 == s1);
+				Assert::IsTrue(r2 == s2);
+			}
+		}
+
+		TEST_METHOD(reduceWideValues)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			unsigned char bytes[F::LIMBS * 4], wide[F::LIMBS * 8];
+
+			F::Int m, r;
+			F::Wide x;
+			F::Modulus M;
+			key.q->toBytes(bytes, sizeof(bytes));
+			F::fromBytes(m, bytes, sizeof(bytes));
+			F::initModulus(M, m);
+
+			std::vector<unsigned char> value = _bytes(sizeof(wide), 7);
+			value[0] = 0xff;	// above m * R
+			F::fromBytes(x, value.data(), value.size());
+			F::reduce(r, x, M);
+
+			BigInteger big, fixed;
+			big.fromBytes(value.data(), value.size());
+			F::toBytes(bytes, sizeof(bytes), r);
+			fixed.fromBytes(bytes, sizeof(bytes));
+
+			Assert::AreEqual(_hex(big.mod(*key.q)), fixed.toString());
+		}
+
+		TEST_METHOD(widthPickedAtPrepare)
+		{
+			std::string pem1024 = TEST_PRIVATE_KEY_1024, pem2048 = TEST_PRIVATE_KEY_2048, pem3072 = TEST_PRIVATE_KEY_3072, pem4096 = TEST_PRIVATE_KEY_4096;
+			RSAKey key1024(pem1024), key2048(pem2048), key3072(pem3072), key4096(pem4096);
+
+			key1024.prepare();
+			key2048.prepare();
+			key3072.prepare();
+			key4096.prepare();
+
+			Assert::IsTrue(key1024.fixed == NULL);
+			Assert::AreEqual(1024, key2048.fixed->bits());
+			Assert::AreEqual(1536, key3072.fixed->bits());
+			Assert::AreEqual(2048, key4096.fixed->bits());
+
+			// multi-prime keys go by their largest prime: about 340, 680 and 1024 bits
+			std::string pem1024x3 = TEST_PRIVATE_KEY_1024_3P, pem2048x3 = TEST_PRIVATE_KEY_2048_3P, pem4096x4 = TEST_PRIVATE_KEY_4096_4P;
+			RSAKey key1024x3(pem1024x3), key2048x3(pem2048x3), key4096x4(pem4096x4);
+
+			key1024x3.prepare();
+			key2048x3.prepare();
+			key4096x4.prepare();
+
+			Assert::IsTrue(key1024x3.fixed == NULL);
+			Assert::AreEqual(768, key2048x3.fixed->bits());
+			Assert::AreEqual(1024, key4096x4.fixed->bits());
+		}
+
+		TEST_METHOD(createJWTEveryWidth)
+		{
+			Assert::AreEqual(TEST_JWT_1024, RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, TEST_PRIVATE_KEY_1024));
+			Assert::AreEqual(TEST_JWT_2048, RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, TEST_PRIVATE_KEY_2048));
+			Assert::AreEqual(TEST_JWT_3072, RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, TEST_PRIVATE_KEY_3072));
+			Assert::AreEqual(TEST_JWT_4096, RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, TEST_PRIVATE_KEY_4096));
+		}
+	};
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "TestKeys.h"
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace KeyGenTest
+{
+	// s^e mod n must be the PKCS#1 v1.5 block around hash
+	static bool _verifies(RSAKey& key, const unsigned char hash[32]) {
+		std::vector<unsigned char> signature(key.signatureLength()), block(key.signatureLength());
+		key.sign(hash, signature.data());
+
+		BigInteger s, e;
+		s.fromBytes(signature.data(), signature.size());
+		e.fromInt(key.e);
+		BigInteger* m = s.modPow(e, *key.n);
+		m->toBytes(block.data(), block.size());
+		delete(m);
+
+		return block[0] == 0x00 && block[1] == 0x01 && block[2] == 0xff
+			&& std::equal(hash, hash + 32, block.end() - 32);
+	}
+
+	TEST_CLASS(KeyGenTest)
+	{
+	public:
+
+		TEST_METHOD(generateTwoPrimes)
+		{
+			unsigned char hash[32];
+			for (int i = 0; i < 32; i++) hash[i] = (unsigned char)(i * 7 + 1);
+
+			RSAKey* key = RSAKey::generate(1024, 65537, 2, 2);
+			Assert::AreEqual(1024, key->n->bitLength());
+			Assert::AreEqual(512, key->p->bitLength());
+			Assert::AreEqual(512, key->q->bitLength());
+			Assert::IsTrue(_verifies(*key, hash));
+
+			// the PEM reads back into the same key
+			std::string pem = key->toPEM();
+			RSAKey parsed(pem);
+			Assert::AreEqual(key->n->toString(), parsed.n->toString());
+			Assert::AreEqual(key->d->toString(), parsed.d->toString());
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *key), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, parsed));
+			delete(key);
+		}
+
+		TEST_METHOD(generateMultiPrime)
+		{
+			unsigned char hash[32];
+			for (int i = 0; i < 32; i++) hash[i] = (unsigned char)(255 - i);
+
+			RSAKey* key3 = RSAKey::generate(1024, 65537, 3);
+			Assert::AreEqual(1024, key3->n->bitLength());
+			Assert::AreEqual((size_t)1, key3->otherPrimes.size());
+			Assert::IsTrue(_verifies(*key3, hash));
+
+			RSAKey* key4 = RSAKey::generate(1536, 3, 4, 1);
+			Assert::AreEqual(1536, key4->n->bitLength());
+			Assert::AreEqual((size_t)2, key4->otherPrimes.size());
+			Assert::IsTrue(_verifies(*key4, hash));
+
+			std::string pem = key4->toPEM();
+			RSAKey parsed(pem);
+			Assert::AreEqual((size_t)2, parsed.otherPrimes.size());
+			Assert::AreEqual(key4->otherPrimes[1].t->toString(), parsed.otherPrimes[1].t->toString());
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *key4), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, parsed));
+
+			delete(key3);
+			delete(key4);
+		}
+
+		TEST_METHOD(toDERMatchesSource)
+		{
+			std::string pems[3] = { TEST_PRIVATE_KEY_2048, TEST_PRIVATE_KEY_1024_3P, TEST_PRIVATE_KEY_4096_4P };
+			for (int i = 0; i < 3; i++) {
+				std::vector<unsigned char> source, written;
+				RSAKey::pemToDER(pems[i].data(), pems[i].size(), source);
+
+				RSAKey key(pems[i]);
+				key.toDER(written);
+				Assert::IsTrue(source == written);
+			}
+		}
+
+		TEST_METHOD(modInverse)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+
+			BigInteger* coeff = key.q->modInverse(*key.p);
+			Assert::AreEqual(key.coeff->toString(), coeff->toString());
+			delete(coeff);
+
+			// n is a multiple of p
+			BigInteger* reduced = key.n->modInverse(*key.p);
+			Assert::IsTrue(reduced == NULL);
+
+			BigInteger six, nine;
+			six.fromInt(6);
+			nine.fromInt(9);
+			Assert::IsTrue(six.modInverse(nine) == NULL);
+
+			BigInteger* inverse = nine.modInverse(*key.p);
+			BigInteger* product = inverse->multiply(nine);
+			BigInteger* one = product->mod(*key.p);
+			Assert::AreEqual(std::string("1"), one->toString());
+			delete(inverse);
+			delete(product);
+			delete(one);
+		}
+
+		TEST_METHOD(generateRejectsBadArguments)
+		{
+			Assert::ExpectException<std::invalid_argument>([]() { RSAKey::generate(2048, 65537, 1); });
+			Assert::ExpectException<std::invalid_argument>([]() { RSAKey::generate(2048, 65537, 5); });
+			Assert::ExpectException<std::invalid_argument>([]() { RSAKey::generate(256); });
+			Assert::ExpectException<std::invalid_argument>([]() { RSAKey::generate(2048, 65536); });
+			Assert::ExpectException<std::invalid_argument>([]() { RSAKey::generate(2048, 1); });
+		}
+	};
+}
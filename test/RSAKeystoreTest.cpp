@@ -0,0 +1,230 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../RSAKeystore.h"
+#include "TestKeys.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#ifdef RSALITE_HAS_STRING_VIEW
+#include <filesystem>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RSAKeystoreTest
+{
+	TEST_CLASS(RSAKeystoreTest)
+	{
+	public:
+
+		TEST_METHOD(keyFromDER)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			std::vector<unsigned char> der;
+			RSAKey::pemToDER(pem.data(), pem.size(), der);
+
+			RSAKey fromPEM(pem);
+			RSAKey fromDER(der.data(), der.size());
+
+			Assert::AreEqual(fromPEM.n->toString().c_str(), fromDER.n->toString().c_str());
+			Assert::AreEqual(fromPEM.coeff->toString().c_str(), fromDER.coeff->toString().c_str());
+			Assert::AreEqual(65537, fromDER.e);
+			Assert::AreEqual(TEST_JWT_2048.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, fromDER).c_str());
+		}
+
+		TEST_METHOD(loadPEMBundle)
+		{
+			std::string path = "rsakeystore_test_bundle.pem";
+			{
+				std::ofstream out(path.c_str(), std::ios::binary);
+				out << TEST_PRIVATE_KEY_2048 << "\n" << TEST_PRIVATE_KEY_2048 << "\n";
+			}
+
+			RSAKeystore keystore;
+			size_t loaded = keystore.loadBundle(path, 2);
+			std::remove(path.c_str());
+
+			Assert::AreEqual((size_t)2, loaded);
+			Assert::AreEqual((size_t)0, keystore.lastLoad().failures);
+			Assert::IsTrue(keystore.get("rsakeystore_test_bundle#1") != NULL);
+			Assert::AreEqual(TEST_JWT_2048.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *keystore.at(1)).c_str());
+		}
+
+		TEST_METHOD(loadDERBundle)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			std::vector<unsigned char> der;
+			RSAKey::pemToDER(pem.data(), pem.size(), der);
+
+			std::string path = "rsakeystore_test_bundle.der";
+			{
+				std::ofstream out(path.c_str(), std::ios::binary);
+				for (int i = 0; i < 3; i++) out.write((const char*)der.data(), der.size());
+				out.write("\x30\x03\x02\x01\x00", 5);
+			}
+
+			RSAKeystore keystore;
+			size_t loaded = keystore.loadBundle(path);
+			std::remove(path.c_str());
+
+			Assert::AreEqual((size_t)3, loaded);
+			Assert::AreEqual((size_t)1, keystore.lastLoad().failures);
+			Assert::AreEqual((size_t)1, keystore.errors.size());
+			Assert::AreEqual(TEST_JWT_2048.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *keystore.at(2)).c_str());
+
+			// a reused keystore reports only the errors of its last load
+			{
+				std::ofstream out(path.c_str(), std::ios::binary);
+				out.write((const char*)der.data(), der.size());
+			}
+			keystore.loadBundle(path);
+			std::remove(path.c_str());
+
+			Assert::AreEqual((size_t)0, keystore.lastLoad().failures);
+			Assert::AreEqual((size_t)0, keystore.errors.size());
+		}
+
+		TEST_METHOD(snapshotRoundTrip)
+		{
+			std::string bundle = "rsakeystore_test_snap.pem";
+			std::string image = "rsakeystore_test.snap";
+			{
+				std::ofstream out(bundle.c_str(), std::ios::binary);
+				out << TEST_PRIVATE_KEY_2048;
+			}
+
+			RSAKeystore source;
+			source.loadBundle(bundle);
+			source.saveSnapshot(image);
+
+			RSAKeystore restored;
+			size_t loaded = restored.loadSnapshot(image);
+
+			Assert::AreEqual((size_t)1, loaded);
+			Assert::IsTrue(restored.lastLoad().fromSnapshot);
+			Assert::IsTrue(restored.at(0)->pMont != NULL);
+			Assert::AreEqual(TEST_JWT_2048.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *restored.get("rsakeystore_test_snap#0")).c_str());
+
+			// flip one limb byte, the checksum must reject the image and the bundle gets reparsed
+			{
+				std::fstream f(image.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+				f.seekp(200);
+				f.put('\x5a');
+			}
+
+			RSAKeystore fallback;
+			loaded = fallback.loadSnapshot(image, bundle);
+			Assert::AreEqual((size_t)1, loaded);
+			Assert::IsFalse(fallback.lastLoad().fromSnapshot);
+			Assert::AreEqual("snapshot checksum mismatch", fallback.lastLoad().snapshotError.c_str());
+			Assert::AreEqual(TEST_JWT_2048.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *fallback.at(0)).c_str());
+
+			// the fallback rewrote a valid image
+			RSAKeystore again;
+			again.loadSnapshot(image);
+			Assert::IsTrue(again.lastLoad().fromSnapshot);
+
+			std::remove(bundle.c_str());
+			std::remove(image.c_str());
+		}
+
+		TEST_METHOD(snapshotFollowsSource)
+		{
+			std::string bundle = "rsakeystore_test_rotate.pem";
+			std::string image = "rsakeystore_test_rotate.snap";
+			{
+				std::ofstream out(bundle.c_str(), std::ios::binary);
+				out << TEST_PRIVATE_KEY_2048;
+			}
+
+			RSAKeystore source;
+			source.loadBundle(bundle);
+			source.saveSnapshot(image, bundle);
+
+			RSAKeystore restored;
+			restored.loadSnapshot(image, bundle);
+			Assert::IsTrue(restored.lastLoad().fromSnapshot);
+
+			// a rotated key in the source outranks the still valid image
+			{
+				std::ofstream out(bundle.c_str(), std::ios::binary | std::ios::trunc);
+				out << TEST_PRIVATE_KEY_1024;
+			}
+
+			RSAKeystore rotated;
+			Assert::AreEqual((size_t)1, rotated.loadSnapshot(image, bundle));
+			Assert::IsFalse(rotated.lastLoad().fromSnapshot);
+			Assert::AreEqual("snapshot is out of date with its source", rotated.lastLoad().snapshotError.c_str());
+			Assert::AreEqual(TEST_JWT_1024.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *rotated.at(0)).c_str());
+
+			// and the rewritten image matches the new source
+			RSAKeystore again;
+			again.loadSnapshot(image, bundle);
+			Assert::IsTrue(again.lastLoad().fromSnapshot);
+			Assert::AreEqual(TEST_JWT_1024.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *again.at(0)).c_str());
+
+			std::remove(bundle.c_str());
+			std::remove(image.c_str());
+		}
+
+#ifdef RSALITE_HAS_STRING_VIEW
+		TEST_METHOD(directoryFingerprintIgnoresPathSpelling)
+		{
+			std::string dir = "rsakeystore_test_dir";
+			std::string image = "rsakeystore_test_dir.snap";
+			std::filesystem::create_directory(dir);
+			{
+				std::ofstream a((dir + "/a.pem").c_str(), std::ios::binary);
+				a << TEST_PRIVATE_KEY_2048;
+				std::ofstream b((dir + "/b.pem").c_str(), std::ios::binary);
+				b << TEST_PRIVATE_KEY_1024;
+			}
+
+			std::string fingerprint = RSAKeystore::fingerprint(dir);
+			Assert::IsFalse(fingerprint.empty());
+			Assert::IsTrue(fingerprint == RSAKeystore::fingerprint("./" + dir));
+			Assert::IsTrue(fingerprint == RSAKeystore::fingerprint(std::filesystem::absolute(dir).string()));
+
+			RSAKeystore source;
+			Assert::AreEqual((size_t)2, source.loadDirectory(dir, 2));
+			source.saveSnapshot(image, dir, 2);
+
+			RSAKeystore restored;
+			Assert::AreEqual((size_t)2, restored.loadSnapshot(image, "./" + dir));
+			Assert::IsTrue(restored.lastLoad().fromSnapshot);
+			Assert::AreEqual(TEST_JWT_1024.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *restored.get("b")).c_str());
+
+			std::filesystem::remove_all(dir);
+			std::remove(image.c_str());
+		}
+#endif
+
+		TEST_METHOD(snapshotMultiPrime)
+		{
+			std::string bundle = "rsakeystore_test_multi.pem";
+			std::string image = "rsakeystore_test_multi.snap";
+			{
+				std::ofstream out(bundle.c_str(), std::ios::binary);
+				out << TEST_PRIVATE_KEY_1024_3P << "\n" << TEST_PRIVATE_KEY_4096_4P;
+			}
+
+			RSAKeystore source;
+			source.loadBundle(bundle);
+			source.saveSnapshot(image);
+
+			RSAKeystore restored;
+			Assert::AreEqual((size_t)2, restored.loadSnapshot(image));
+			Assert::IsTrue(restored.lastLoad().fromSnapshot);
+			Assert::AreEqual((size_t)1, restored.at(0)->otherPrimes.size());
+			Assert::AreEqual((size_t)2, restored.at(1)->otherPrimes.size());
+			Assert::IsTrue(restored.at(1)->otherPrimes[1].mont != NULL);
+			Assert::AreEqual(TEST_JWT_1024_3P.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *restored.at(0)).c_str());
+			Assert::AreEqual(TEST_JWT_4096_4P.c_str(), RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *restored.at(1)).c_str());
+
+			std::remove(bundle.c_str());
+			std::remove(image.c_str());
+		}
+	};
+}
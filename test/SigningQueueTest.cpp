@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../SigningQueue.h"
+#include "TestKeys.h"
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SigningQueueTest
+{
+	// Holds the queue's only signer thread inside a completion callback
+	// until release() so tests control what is pending
+	struct Gate
+	{
+		std::promise<void> entered;
+		std::promise<void> opened;
+		std::shared_future<void> open = opened.get_future().share();
+
+		SigningQueue::Callback callback() {
+			return [this](const std::string&, std::exception_ptr) {
+				this->entered.set_value();
+				this->open.wait();
+			};
+		}
+
+		void block(SigningQueue& queue, HMACSHA256& key) {
+			Assert::IsTrue(queue.trySubmit(TEST_HEADER, TEST_PAYLOAD, key, this->callback()));
+			this->entered.get_future().wait();
+		}
+
+		void release() { this->opened.set_value(); }
+	};
+
+	TEST_CLASS(SigningQueueTest)
+	{
+	public:
+
+		TEST_METHOD(futureMatchesCreateJWT)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			SigningQueue queue(2, 8);
+
+			std::future<std::string> jwt = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+
+			Assert::AreEqual(TEST_JWT_2048, jwt.get());
+		}
+
+		TEST_METHOD(rejectsWhenFull)
+		{
+			HMACSHA256 key(std::string("secret"));
+			SigningQueue queue(1, 2);
+			Gate gate;
+
+			gate.block(queue, key);
+
+			std::future<std::string> a = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+			std::future<std::string> b = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+			std::future<std::string> c = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+
+			Assert::AreEqual((size_t)2, queue.pending());
+			Assert::AreEqual((uint64_t)1, queue.rejected());
+			Assert::ExpectException<SigningQueue::Rejected>([&]() { c.get(); });
+
+			gate.release();
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key), a.get());
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, key), b.get());
+		}
+
+		TEST_METHOD(earliestDeadlineFirst)
+		{
+			HMACSHA256 key(std::string("secret"));
+			SigningQueue queue(1, 8);
+			Gate gate;
+			std::mutex lock;
+			std::vector<std::string> order;
+
+			gate.block(queue, key);
+
+			SigningQueue::Clock::time_point now = SigningQueue::Clock::now();
+			const char* names[] = { "none", "late", "soon", "late2" };
+			SigningQueue::Clock::time_point deadlines[] = {
+				SigningQueue::noDeadline(),
+				now + std::chrono::seconds(20),
+				now + std::chrono::seconds(10),
+				now + std::chrono::seconds(20)
+			};
+
+			for (int i = 0; i < 4; i++) {
+				std::string name = names[i];
+				queue.trySubmit(TEST_HEADER, TEST_PAYLOAD, key, [&lock, &order, name](const std::string&, std::exception_ptr) {
+					std::lock_guard<std::mutex> guard(lock);
+					order.push_back(name);
+				}, deadlines[i]);
+			}
+
+			std::future<std::string> last = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+			gate.release();
+			last.get();
+
+			std::lock_guard<std::mutex> guard(lock);
+			Assert::AreEqual((size_t)4, order.size());
+			Assert::AreEqual(std::string("soon"), order[0]);
+			Assert::AreEqual(std::string("late"), order[1]);
+			Assert::AreEqual(std::string("late2"), order[2]);
+			Assert::AreEqual(std::string("none"), order[3]);
+		}
+
+		TEST_METHOD(expiredRequestsAreNotSigned)
+		{
+			HMACSHA256 key(std::string("secret"));
+			SigningQueue queue(1, 8);
+			Gate gate;
+
+			gate.block(queue, key);
+
+			std::future<std::string> jwt = queue.submit(TEST_HEADER, TEST_PAYLOAD, key, SigningQueue::Clock::now() + std::chrono::milliseconds(1));
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			gate.release();
+
+			Assert::ExpectException<SigningQueue::DeadlineExceeded>([&]() { jwt.get(); });
+			Assert::AreEqual((uint64_t)1, queue.expired());
+		}
+
+		TEST_METHOD(destructorFailsPending)
+		{
+			HMACSHA256 key(std::string("secret"));
+			std::future<std::string> jwt;
+			std::thread opener;
+			Gate gate;
+
+			{
+				SigningQueue queue(1, 8);
+				gate.block(queue, key);
+				jwt = queue.submit(TEST_HEADER, TEST_PAYLOAD, key);
+
+				// the destructor waits for the request being signed
+				opener = std::thread([&gate]() {
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+					gate.release();
+				});
+			}
+			opener.join();
+
+			Assert::ExpectException<SigningQueue::Rejected>([&]() { jwt.get(); });
+		}
+	};
+}
@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../RSALiteStats.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace StatsTest
+{
+	TEST_CLASS(StatsTest)
+	{
+	public:
+
+		TEST_METHOD(histogramBuckets)
+		{
+			const uint64_t values[] = { 0, 1, 15, 16, 17, 31, 32, 1000, 123456789, 1ULL << 40 };
+
+			for (uint64_t v : values) {
+				int b = RSALiteHistogram::bucketIndex(v);
+				Assert::IsTrue(RSALiteHistogram::bucketLower(b) <= v);
+				Assert::IsTrue(v <= RSALiteHistogram::bucketUpper(b));
+			}
+
+			Assert::AreEqual(RSALiteHistogram::BUCKETS - 1, RSALiteHistogram::bucketIndex(1ULL << 50));
+			Assert::AreEqual((uint64_t)1000, RSALiteHistogram::bucketLower(RSALiteHistogram::bucketIndex(1000)) + 8);
+		}
+
+		TEST_METHOD(stagesRecorded)
+		{
+			std::string header = "{\"alg\":\"HS256\",\"typ\":\"JWT\"}";
+			std::string payload = "{\"sub\":\"x\"}";
+
+			RSALite::resetStats();
+			for (int i = 0; i < 3; i++) RSALite::createJWT(header, payload, "secret", RSALite::HS256);
+
+			RSALiteStats stats = RSALite::stats();
+			std::string prometheus = RSALite::statsPrometheus();
+
+#ifdef RSALITE_STATS
+			Assert::IsTrue(stats.enabled);
+			Assert::AreEqual((uint64_t)3, stats.stage(STAGE_PARSE).count);
+			Assert::AreEqual((uint64_t)3, stats.stage(STAGE_SIGN).count);
+			Assert::AreEqual((uint64_t)3, stats.stage(STAGE_ENCODE).count);
+			Assert::AreEqual((uint64_t)3, stats.stage(STAGE_TOTAL).count);
+			Assert::AreEqual((uint64_t)0, stats.stage(STAGE_EXP_P).count);
+			Assert::IsTrue(stats.stage(STAGE_TOTAL).percentile(50) <= stats.stage(STAGE_TOTAL).maxNanos);
+			Assert::IsTrue(prometheus.find("rsalite_stage_seconds_count{stage=\"sign\"} 3\n") != std::string::npos);
+			Assert::IsTrue(prometheus.find("rsalite_stage_seconds_bucket{stage=\"total\",le=\"+Inf\"} 3\n") != std::string::npos);
+#else
+			Assert::IsFalse(stats.enabled);
+			Assert::AreEqual((uint64_t)0, stats.stage(STAGE_TOTAL).count);
+#endif
+		}
+	};
+}
@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../TokenCache.h"
+#include "TestKeys.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TokenCacheTest
+{
+	static std::string _payloadExpiringIn(long long seconds, const std::string& sub = "1234567890") {
+		long long now = std::chrono::duration_cast<std::chrono::seconds>(TokenCache::Clock::now().time_since_epoch()).count();
+		return "{\"sub\":\"" + sub + "\",\"exp\":" + std::to_string(now + seconds) + "}";
+	}
+
+	TEST_CLASS(TokenCacheTest)
+	{
+	public:
+
+		TEST_METHOD(hitReturnsSameToken)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenCache cache;
+			std::string payload = _payloadExpiringIn(3600);
+
+			std::string first = cache.createJWT("k1", TEST_HEADER, payload, key);
+			std::string second = cache.createJWT("k1", TEST_HEADER, payload, key);
+
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, key), first);
+			Assert::AreEqual(first, second);
+
+			TokenCacheStats stats = cache.stats();
+			Assert::AreEqual((uint64_t)1, stats.misses);
+			Assert::AreEqual((uint64_t)1, stats.hits);
+			Assert::AreEqual((size_t)1, stats.entries);
+		}
+
+		TEST_METHOD(keyIdIsPartOfTheKey)
+		{
+			HMACSHA256 a(std::string("secret"));
+			HMACSHA256 b(std::string("other secret"));
+			TokenCache cache;
+
+			std::string jwtA = cache.createJWT("a", TEST_HEADER, TEST_PAYLOAD, a);
+			std::string jwtB = cache.createJWT("b", TEST_HEADER, TEST_PAYLOAD, b);
+
+			Assert::IsTrue(jwtA != jwtB);
+			Assert::AreEqual(jwtB, cache.createJWT("b", TEST_HEADER, TEST_PAYLOAD, b));
+			Assert::AreEqual((uint64_t)2, cache.stats().misses);
+		}
+
+		TEST_METHOD(expiringTokensAreNotKept)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenCache cache(16, 4, std::chrono::seconds(30));
+			std::string payload = _payloadExpiringIn(10);
+
+			cache.createJWT("k", TEST_HEADER, payload, key);
+			cache.createJWT("k", TEST_HEADER, payload, key);
+
+			TokenCacheStats stats = cache.stats();
+			Assert::AreEqual((uint64_t)2, stats.uncacheable);
+			Assert::AreEqual((uint64_t)0, stats.hits);
+			Assert::AreEqual((size_t)0, stats.entries);
+		}
+
+		TEST_METHOD(unparsableExpIsNotKept)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenCache cache(16, 4, std::chrono::seconds(30));
+			std::string payload = "{\"sub\":\"x\",\"exp\":\"1700000000\"}";
+
+			std::string jwt = cache.createJWT("k", TEST_HEADER, payload, key);
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, key), cache.createJWT("k", TEST_HEADER, payload, key));
+			Assert::IsFalse(jwt.empty());
+
+			TokenCacheStats stats = cache.stats();
+			Assert::AreEqual((uint64_t)2, stats.uncacheable);
+			Assert::AreEqual((uint64_t)0, stats.hits);
+			Assert::AreEqual((size_t)0, stats.entries);
+		}
+
+		TEST_METHOD(leastRecentlyUsedIsEvicted)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenCache cache(2, 1);
+
+			cache.createJWT("k", TEST_HEADER, "{\"n\":1}", key);
+			cache.createJWT("k", TEST_HEADER, "{\"n\":2}", key);
+			cache.createJWT("k", TEST_HEADER, "{\"n\":1}", key);
+			cache.createJWT("k", TEST_HEADER, "{\"n\":3}", key);	// evicts n=2
+
+			cache.createJWT("k", TEST_HEADER, "{\"n\":1}", key);
+			cache.createJWT("k", TEST_HEADER, "{\"n\":2}", key);
+
+			TokenCacheStats stats = cache.stats();
+			Assert::AreEqual((uint64_t)2, stats.hits);
+			Assert::AreEqual((uint64_t)4, stats.misses);
+			Assert::AreEqual((uint64_t)2, stats.evictions);
+			Assert::AreEqual((size_t)2, stats.entries);
+		}
+
+		TEST_METHOD(concurrentMissesMintOnce)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			TokenCache cache;
+			std::vector<std::thread> threads;
+			std::vector<std::string> results(8);
+
+			for (size_t i = 0; i < results.size(); i++) {
+				threads.push_back(std::thread([&cache, &key, &results, i]() {
+					results[i] = cache.createJWT("rsa", TEST_HEADER, TEST_PAYLOAD, key);
+				}));
+			}
+			for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+			for (size_t i = 0; i < results.size(); i++) Assert::AreEqual(TEST_JWT_2048, results[i]);
+
+			TokenCacheStats stats = cache.stats();
+			Assert::AreEqual((uint64_t)1, stats.misses);
+			Assert::AreEqual((uint64_t)7, stats.hits);
+		}
+
+		TEST_METHOD(expClaim)
+		{
+			long long exp = 0;
+
+			Assert::IsTrue(TokenCache::EXP_VALID == TokenCache::expClaim("{\"sub\":\"x\", \"exp\" : 1700000000}", exp));
+			Assert::AreEqual(1700000000LL, exp);
+			Assert::IsTrue(TokenCache::EXP_VALID == TokenCache::expClaim("{\"note\":\"exp\",\"exp\":42}", exp));
+			Assert::AreEqual(42LL, exp);
+			Assert::IsTrue(TokenCache::EXP_VALID == TokenCache::expClaim("{\"exp\":1700000000.75 }", exp));
+			Assert::AreEqual(1700000000LL, exp);
+			Assert::IsTrue(TokenCache::EXP_ABSENT == TokenCache::expClaim(TEST_PAYLOAD, exp));
+
+			// present but not a NumericDate
+			Assert::IsTrue(TokenCache::EXP_UNPARSABLE == TokenCache::expClaim("{\"exp\":\"soon\"}", exp));
+			Assert::IsTrue(TokenCache::EXP_UNPARSABLE == TokenCache::expClaim("{\"exp\":\"1700000000\"}", exp));
+			Assert::IsTrue(TokenCache::EXP_UNPARSABLE == TokenCache::expClaim("{\"exp\":-5}", exp));
+			Assert::IsTrue(TokenCache::EXP_UNPARSABLE == TokenCache::expClaim("{\"exp\":null}", exp));
+			Assert::IsTrue(TokenCache::EXP_UNPARSABLE == TokenCache::expClaim("{\"exp\":1.7e9}", exp));
+
+			// nested members and string contents are not the token's exp
+			Assert::IsTrue(TokenCache::EXP_VALID == TokenCache::expClaim("{\"ctx\":{\"exp\":9999999999},\"exp\":1700000000}", exp));
+			Assert::AreEqual(1700000000LL, exp);
+			Assert::IsTrue(TokenCache::EXP_VALID == TokenCache::expClaim("{\"a\":[{\"exp\":9999999999}],\"s\":\"\\\"exp\\\":9999999999\",\"exp\":7}", exp));
+			Assert::AreEqual(7LL, exp);
+			Assert::IsTrue(TokenCache::EXP_ABSENT == TokenCache::expClaim("{\"ctx\":{\"exp\":\"soon\"}}", exp));
+		}
+	};
+}
@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../TokenRefresher.h"
+#include "TestKeys.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TokenRefresherTest
+{
+	TEST_CLASS(TokenRefresherTest)
+	{
+	public:
+
+		TEST_METHOD(mintsOnAdd)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenRefresher refresher;
+
+			std::shared_ptr<TokenRefresher::Slot> slot = refresher.add(TEST_HEADER, "{\"sub\":\"svc\"}", key, std::chrono::seconds(300));
+			std::shared_ptr<const TokenRefresher::Token> token = slot->current();
+
+			Assert::AreEqual(token->iat + 300, token->exp);
+			std::string payload = "{\"sub\":\"svc\",\"iat\":" + std::to_string(token->iat) + ",\"exp\":" + std::to_string(token->exp) + "}";
+			Assert::AreEqual(RSALite::createJWT(TEST_HEADER, payload, key), token->jwt);
+			Assert::AreEqual((uint64_t)1, slot->mints());
+		}
+
+		TEST_METHOD(replacesAheadOfExpiry)
+		{
+			std::string pem = TEST_PRIVATE_KEY_2048;
+			RSAKey key(pem);
+			TokenRefresher refresher;
+
+			// due 50 ms after each mint
+			std::shared_ptr<TokenRefresher::Slot> slot = refresher.add(TEST_HEADER, "{\"sub\":\"svc\"}", key, std::chrono::seconds(300), std::chrono::milliseconds(299950));
+			std::shared_ptr<const TokenRefresher::Token> first = slot->current();
+
+			for (int i = 0; i < 200 && slot->mints() < 3; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+			Assert::IsTrue(slot->mints() >= 3);
+			Assert::IsTrue(slot->current() != first);
+			Assert::IsTrue(slot->current()->exp >= first->exp);
+			Assert::AreEqual((uint64_t)0, slot->failures());
+		}
+
+		TEST_METHOD(removedSlotsStopRefreshing)
+		{
+			std::string pem = TEST_PRIVATE_KEY_4096;
+			RSAKey* key = new RSAKey(pem);
+			TokenRefresher refresher;
+
+			// due again every 10ms with a slow key, so a mint is almost always under way
+			std::shared_ptr<TokenRefresher::Slot> slot = refresher.add(TEST_HEADER, "{}", *key, std::chrono::seconds(300), std::chrono::milliseconds(299990));
+			std::this_thread::sleep_for(std::chrono::milliseconds(25));
+			refresher.remove(slot);
+			delete key;
+
+			uint64_t mints = slot->mints();
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			Assert::AreEqual(mints, slot->mints());
+			Assert::IsTrue(slot->current() != NULL);
+		}
+
+		TEST_METHOD(withTimes)
+		{
+			Assert::AreEqual(std::string("{\"iat\":1,\"exp\":2}"), TokenRefresher::withTimes("{}", 1, 2));
+			Assert::AreEqual(std::string("{ \"sub\":\"a\" ,\"iat\":1,\"exp\":2}"), TokenRefresher::withTimes("{ \"sub\":\"a\" }", 1, 2));
+			Assert::ExpectException<std::invalid_argument>([]() { TokenRefresher::withTimes("sub", 1, 2); });
+		}
+
+		TEST_METHOD(rejectsLeadLongerThanLifetime)
+		{
+			HMACSHA256 key(std::string("secret"));
+			TokenRefresher refresher;
+
+			Assert::ExpectException<std::invalid_argument>([&]() {
+				refresher.add(TEST_HEADER, "{}", key, std::chrono::seconds(60), std::chrono::seconds(60));
+			});
+		}
+	};
+}
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../RSALite.h"
+#include "../RSAPublicKey.h"
+#include "../FixedBigInt.h"
+#include "TestKeys.h"
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace VerifyTest
+{
+	TEST_CLASS(VerifyTest)
+	{
+	public:
+
+		TEST_METHOD(verifySPKIAndPKCS1)
+		{
+			std::string spki = TEST_PUBLIC_KEY_2048, pkcs1 = TEST_RSA_PUBLIC_KEY_2048, pem = TEST_PRIVATE_KEY_2048;
+			RSAPublicKey fromSPKI(spki), fromPKCS1(pkcs1);
+			RSAKey key(pem);
+
+			Assert::AreEqual(key.n->toString(), fromSPKI.n->toString());
+			Assert::AreEqual(key.n->toString(), fromPKCS1.n->toString());
+			Assert::AreEqual(65537, fromSPKI.e);
+			Assert::AreEqual((size_t)256, fromSPKI.signatureLength());
+
+			Assert::IsTrue(RSALite::verifyJWT(TEST_JWT_2048, fromSPKI));
+			Assert::IsTrue(RSALite::verifyJWT(TEST_JWT_2048, fromPKCS1));
+		}
+
+		TEST_METHOD(verifyEveryKeySize)
+		{
+			std::string pems[6] = { TEST_PRIVATE_KEY_1024, TEST_PRIVATE_KEY_3072, TEST_PRIVATE_KEY_4096, TEST_PRIVATE_KEY_1024_3P, TEST_PRIVATE_KEY_2048_3P, TEST_PRIVATE_KEY_4096_4P };
+			std::string jwts[6] = { TEST_JWT_1024, TEST_JWT_3072, TEST_JWT_4096, TEST_JWT_1024_3P, TEST_JWT_2048_3P, TEST_JWT_4096_4P };
+
+			for (int i = 0; i < 6; i++) {
+				RSAKey key(pems[i]);
+				RSAPublicKey publicKey(key);
+				Assert::IsTrue(RSALite::verifyJWT(jwts[i], publicKey));
+				Assert::IsFalse(RSALite::verifyJWT(jwts[(i + 1) % 6], publicKey));
+			}
+		}
+
+		TEST_METHOD(rejectTampered)
+		{
+			std::string spki = TEST_PUBLIC_KEY_2048;
+			RSAPublicKey key(spki);
+			std::string jwt = TEST_JWT_2048;
+			size_t dot2 = jwt.rfind('.');
+
+			std::string payload = jwt;
+			payload[dot2 - 3] = payload[dot2 - 3] == 'A' ? 'B' : 'A';
+			Assert::IsFalse(RSALite::verifyJWT(payload, key));
+
+			std::string signature = jwt;
+			signature[dot2 + 10] = signature[dot2 + 10] == 'A' ? 'B' : 'A';
+			Assert::IsFalse(RSALite::verifyJWT(signature, key));
+
+			// the last character carries 4 unused bits; only the canonical one is accepted
+			std::string lastChar = jwt;
+			lastChar[jwt.size() - 1] = (char)(lastChar[jwt.size() - 1] + 1);
+			Assert::IsFalse(RSALite::verifyJWT(lastChar, key));
+
+			Assert::IsFalse(RSALite::verifyJWT(jwt + "=", key));
+			Assert::IsFalse(RSALite::verifyJWT(jwt.substr(0, dot2 + 1), key));
+			Assert::IsFalse(RSALite::verifyJWT(jwt.substr(0, dot2), key));
+			Assert::IsFalse(RSALite::verifyJWT("a." + jwt, key));
+			Assert::IsFalse(RSALite::verifyJWT("", key));
+
+			unsigned char hash[32] = {}, zeros[256] = {};
+			Assert::IsFalse(key.verify(hash, zeros, sizeof(zeros)));
+			Assert::IsFalse(key.verify(hash, zeros, sizeof(zeros) - 1));
+		}
+
+		TEST_METHOD(verifyOtherExponentsAndWidths)
+		{
+			// 1024 bits has a fixed width, 1536 runs on BigInteger; e = 3 takes the general exponent path
+			int shapes[3][2] = { { 1024, 3 }, { 1536, 3 }, { 1536, 65537 } };
+			for (int i = 0; i < 3; i++) {
+				RSAKey* key = RSAKey::generate(shapes[i][0], shapes[i][1], 2, 1);
+				RSAPublicKey publicKey(*key);
+				std::string jwt = RSALite::createJWT(TEST_HEADER, TEST_PAYLOAD, *key);
+
+				Assert::AreEqual(shapes[i][1], publicKey.e);
+				Assert::IsTrue(RSALite::verifyJWT(jwt, publicKey));
+				Assert::AreEqual(shapes[i][0] == 1024, publicKey.fixed != NULL);
+
+				jwt[jwt.size() - 8] = jwt[jwt.size() - 8] == 'A' ? 'B' : 'A';
+				Assert::IsFalse(RSALite::verifyJWT(jwt, publicKey));
+				delete(key);
+			}
+		}
+
+		TEST_METHOD(verifyBatch)
+		{
+			std::string spki = TEST_PUBLIC_KEY_2048;
+			RSAPublicKey key(spki);
+
+			std::string bad = TEST_JWT_2048;
+			bad[bad.size() - 5] = bad[bad.size() - 5] == 'A' ? 'B' : 'A';
+
+			std::vector<std::string> jwts;
+			for (int i = 0; i < 70; i++) jwts.push_back(i % 7 == 3 ? bad : TEST_JWT_2048);
+
+			std::vector<char> valid, serial;
+			Assert::AreEqual((size_t)60, RSALite::verifyJWTs(jwts, key, valid, 4));
+			Assert::AreEqual((size_t)60, RSALite::verifyJWTs(jwts, key, serial, 1));
+			Assert::IsTrue(valid == serial);
+			for (size_t i = 0; i < jwts.size(); i++) Assert::AreEqual(i % 7 == 3 ? 0 : 1, (int)valid[i]);
+
+			std::vector<std::string> none;
+			Assert::AreEqual((size_t)0, RSALite::verifyJWTs(none, key, valid));
+			Assert::IsTrue(valid.empty());
+		}
+
+		TEST_METHOD(rejectMalformedKeys)
+		{
+			Assert::ExpectException<std::invalid_argument>([]() { std::string pem = TEST_PRIVATE_KEY_2048; RSAPublicKey key(pem); });
+			Assert::ExpectException<std::invalid_argument>([]() { std::string pem = TEST_PRIVATE_KEY_P256; RSAPublicKey key(pem); });
+
+			unsigned char even[] = { 0x30, 0x06, 0x02, 0x01, 0x10, 0x02, 0x01, 0x03 };
+			Assert::ExpectException<std::invalid_argument>([&even]() { RSAPublicKey key(even, sizeof(even)); });
+
+			// a four-byte exponent with the sign bit set
+			unsigned char negative[] = { 0x30, 0x09, 0x02, 0x01, 0x0d, 0x02, 0x04, 0x80, 0x00, 0x00, 0x01 };
+			Assert::ExpectException<std::invalid_argument>([&negative]() { RSAPublicKey key(negative, sizeof(negative)); });
+		}
+	};
+}
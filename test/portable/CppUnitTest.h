@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef RSALITE_PORTABLE_CPPUNITTEST_H
+#define RSALITE_PORTABLE_CPPUNITTEST_H
+
+// Minimal stand-in for the MSVC CppUnitTest framework so the test sources in
+// test/ build unchanged with CMake on Linux and macOS. Only the subset the
+// tests use is provided; a failed assertion throws.
+namespace Microsoft { namespace VisualStudio { namespace CppUnitTestFramework {
+
+struct TestCase
+{
+    std::string name;
+    std::function<void()> run;
+};
+
+inline std::vector<TestCase>& testRegistry()
+{
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+class AssertFailed : public std::runtime_error
+{
+public:
+    AssertFailed(const std::string& what) : std::runtime_error(what) {}
+};
+
+class Assert
+{
+public:
+    template<typename T>
+    static void AreEqual(const T& expected, const T& actual)
+    {
+        if (!(expected == actual)) {
+            std::ostringstream out;
+            out << "AreEqual failed: expected <" << expected << "> actual <" << actual << ">";
+            throw AssertFailed(out.str());
+        }
+    }
+
+    static void AreEqual(const char* expected, const char* actual)
+    {
+        if (std::strcmp(expected, actual) != 0) {
+            throw AssertFailed(std::string("AreEqual failed: expected <") + expected + "> actual <" + actual + ">");
+        }
+    }
+
+    static void IsTrue(bool condition)
+    {
+        if (!condition) throw AssertFailed("IsTrue failed");
+    }
+
+    static void IsFalse(bool condition)
+    {
+        if (condition) throw AssertFailed("IsFalse failed");
+    }
+
+    template<typename E, typename F>
+    static void ExpectException(F f)
+    {
+        try {
+            f();
+        }
+        catch (E&) {
+            return;
+        }
+        throw AssertFailed("ExpectException failed: nothing thrown");
+    }
+};
+
+class Logger
+{
+public:
+    static void WriteMessage(const char* message)
+    {
+        std::printf("     %s\n", message);
+    }
+};
+
+inline void registerTest(const char* file, const char* method, std::function<void()> run)
+{
+    std::string name = file;
+    size_t slash = name.find_last_of("/\\");
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    name = name.substr(0, name.find('.')) + "::" + method;
+
+    testRegistry().push_back(TestCase{ name, run });
+}
+
+template<typename T>
+struct TestClass
+{
+    typedef T Self;
+};
+
+}}}
+
+#define TEST_CLASS(className) struct className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className>
+#define TEST_METHOD(methodName) \
+    struct _Register_##methodName { \
+        _Register_##methodName() { \
+            ::Microsoft::VisualStudio::CppUnitTestFramework::registerTest(__FILE__, #methodName, []() { Self instance; instance.methodName(); }); \
+        } \
+    }; \
+    inline static _Register_##methodName _register_##methodName; \
+    void methodName()
+
+#endif
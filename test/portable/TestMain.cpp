@@ -0,0 +1,28 @@
+#include "CppUnitTest.h"
+#include <cstdio>
+#include <exception>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// Runs every registered TEST_METHOD, or only those whose name contains argv[1]
+int main(int argc, char** argv) {
+    int failures = 0, run = 0;
+
+    for (size_t i = 0; i < testRegistry().size(); i++) {
+        TestCase& test = testRegistry()[i];
+        if (argc > 1 && test.name.find(argv[1]) == std::string::npos) continue;
+
+        run++;
+        try {
+            test.run();
+            std::printf("PASS %s\n", test.name.c_str());
+        }
+        catch (std::exception& e) {
+            failures++;
+            std::printf("FAIL %s: %s\n", test.name.c_str(), e.what());
+        }
+    }
+
+    std::printf("%d tests, %d failures\n", run, failures);
+    return failures == 0 ? 0 : 1;
+}